@@ -46,9 +46,13 @@ function resolveStockfishPath() {
 }
 
 const STOCKFISH_PATH = resolveStockfishPath();
+// Pistas: bm_engine tiene MultiPV propio; HINT_ENGINE=stockfish vuelve al proceso aparte
+const HINT_ENGINE = process.env.HINT_ENGINE === "stockfish" ? "stockfish" : "bm";
 
 const MOVE_TIMEOUT_MS = 5000;
 const HINT_TIMEOUT_MS = 4000;
+// bm_engine atiende "stop" durante la búsqueda y responde bestmove enseguida
+const STOP_GRACE_MS = 500;
 
 function truncateFen(fen = "", maxLen = 64) {
   if (fen.length <= maxLen) return fen;
@@ -71,8 +75,15 @@ function buildPositionCommand({ fen, moves_uci }) {
   return `position fen ${fen}`;
 }
 
+function numberAfter(tokens, key) {
+  const idx = tokens.indexOf(key);
+  if (idx < 0) return null;
+  const n = Number(tokens[idx + 1]);
+  return Number.isFinite(n) ? n : null;
+}
+
 function parseInfoLine(line) {
-  if (!line.startsWith("info ")) return null;
+  if (!line.startsWith("info ") || line.startsWith("info string")) return null;
 
   const tokens = line.split(/\s+/);
   const depthIdx = tokens.indexOf("depth");
@@ -94,12 +105,31 @@ function parseInfoLine(line) {
 
   return {
     depth: Number.isFinite(depth) ? depth : null,
+    multipv: numberAfter(tokens, "multipv") ?? 1,
+    seldepth: numberAfter(tokens, "seldepth"),
+    nodes: numberAfter(tokens, "nodes"),
+    nps: numberAfter(tokens, "nps"),
+    hashfull: numberAfter(tokens, "hashfull"),
+    timeMs: numberAfter(tokens, "time"),
     score,
     pv,
     raw: line,
   };
 }
 
+// "info string stats [depth N itertime T | total threads N nodes N] qshare .. tthit .. ttcut .. fhfirst .. aspfail .."
+// (solo con "debug on"; ENGINE_DEBUG_STATS=1)
+function parseStatsLine(line) {
+  if (!line.startsWith("info string stats ")) return null;
+  const tokens = line.split(/\s+/).slice(3);
+  const stats = { total: tokens[0] === "total" };
+  for (let i = stats.total ? 1 : 0; i + 1 < tokens.length; i += 2) {
+    const n = Number(tokens[i + 1]);
+    if (Number.isFinite(n)) stats[tokens[i]] = n;
+  }
+  return stats;
+}
+
 function parseStockfishMultipv(line) {
   if (!line.startsWith("info ") || !line.includes(" pv ")) return null;
   const tokens = line.split(/\s+/);
@@ -219,7 +249,7 @@ function createUciClient(binaryPath, args = []) {
 }
 
 const engineClient = createUciClient(ENGINE_PATH);
-const stockfishClient = createUciClient(STOCKFISH_PATH);
+const stockfishClient = HINT_ENGINE === "stockfish" ? createUciClient(STOCKFISH_PATH) : null;
 let stockfishReady = false;
 
 let activeRequestId = null;
@@ -227,19 +257,31 @@ const requestStates = new Map();
 let engineQueue = Promise.resolve();
 let stockfishQueue = Promise.resolve();
 let currentHashMb = 64;
+let currentStrength = null;   // último Skill Level / UCI_Elo mandado al motor
 
 engineClient.onLine((line) => {
   if (!activeRequestId) return;
   const state = requestStates.get(activeRequestId);
   if (!state) return;
 
+  // Con Skill Level bajo el motor imprime varias líneas multipv por depth y puede
+  // jugar cualquiera: lastInfo es la línea 1 hasta el bestmove, después la de la jugada elegida
   const parsedInfo = parseInfoLine(line);
   if (parsedInfo) {
-    state.lastInfo = parsedInfo;
+    const firstMove = parsedInfo.pv.split(" ")[0];
+    if (firstMove) state.infoByMove.set(firstMove, parsedInfo);
+    if (parsedInfo.multipv === 1) state.lastInfo = parsedInfo;
     state.lastInfoAt = Date.now();
     return;
   }
 
+  const stats = parseStatsLine(line);
+  if (stats) {
+    if (stats.total) state.stats = stats;
+    else state.lastIterStats = stats;
+    return;
+  }
+
   if (line.startsWith("info string bookhit")) {
     state.bookhit = line;
     return;
@@ -247,6 +289,7 @@ engineClient.onLine((line) => {
 
   if (line.startsWith("bestmove ")) {
     state.bestmove = line.split(/\s+/)[1] ?? "0000";
+    state.lastInfo = state.infoByMove.get(state.bestmove) ?? state.lastInfo;
     state.active = false;
     state.finishedAt = Date.now();
     activeRequestId = null;
@@ -302,6 +345,12 @@ function serializeState(state) {
     reason: bestmove.reason,
     bestmove: bestmove.uci,
     bookhit: bestmove.bookhit,
+    seldepth: state.lastInfo?.seldepth ?? null,
+    nodes: state.lastInfo?.nodes ?? null,
+    nps: state.lastInfo?.nps ?? null,
+    hashfull: state.lastInfo?.hashfull ?? null,
+    timeMs: state.lastInfo?.timeMs ?? null,
+    stats: state.stats ?? state.lastIterStats ?? null,
     error: state.error ?? null,
   };
 }
@@ -318,9 +367,17 @@ function cleanupOldStates() {
 async function initClients() {
   engineClient.send("uci");
   await engineClient.waitFor((l) => l === "uciok", 3000);
+  if (process.env.ENGINE_DEBUG_STATS === "1") engineClient.send("debug on");
+  // cache persistente compartido entre procesos del host (sobrevive reinicios)
+  if (process.env.ENGINE_SEARCH_CACHE) {
+    if (process.env.ENGINE_SEARCH_CACHE_MB)
+      engineClient.send(`setoption name SearchCacheMB value ${process.env.ENGINE_SEARCH_CACHE_MB}`);
+    engineClient.send(`setoption name SearchCache value ${process.env.ENGINE_SEARCH_CACHE}`);
+  }
   engineClient.send("isready");
   await engineClient.waitFor((l) => l === "readyok", 3000);
 
+  if (!stockfishClient) return;
   try {
     stockfishClient.send("uci");
     await stockfishClient.waitFor((l) => l === "uciok", 3000);
@@ -335,11 +392,30 @@ async function initClients() {
 
 await initClients();
 
+// skill_level < 20: el motor juega con presupuesto de nodos (corta antes del movetime)
 const SKILL_PRESETS = {
+  beginner: { movetime_ms: 300, depth: undefined, hash_mb: 16, skill_level: 2 },
+  casual: { movetime_ms: 300, depth: undefined, hash_mb: 32, skill_level: 8 },
   blitz: { movetime_ms: 200, depth: undefined, hash_mb: 64 },
   rapid: { movetime_ms: 700, depth: undefined, hash_mb: 96 },
   strong: { movetime_ms: 1600, depth: 10, hash_mb: 192 },
 };
+const MAX_SKILL_LEVEL = 20;
+
+function toIntInRange(value, min, max) {
+  if (value === undefined || value === null || value === "") return undefined;
+  const n = Number(value);
+  if (!Number.isFinite(n)) return undefined;
+  return Math.min(max, Math.max(min, Math.floor(n)));
+}
+
+// "Skill Level" o "UCI_Elo"; solo se manda cuando cambia
+function strengthCommands({ skill_level, elo }) {
+  if (elo !== undefined) {
+    return ["setoption name UCI_LimitStrength value true", `setoption name UCI_Elo value ${elo}`];
+  }
+  return ["setoption name UCI_LimitStrength value false", `setoption name Skill Level value ${skill_level}`];
+}
 
 function resolveMoveOptions(payload = {}) {
   const skillRaw = typeof payload.skill === "string" ? payload.skill.toLowerCase().trim() : undefined;
@@ -348,8 +424,10 @@ function resolveMoveOptions(payload = {}) {
   const movetime_ms = toPositiveInt(payload.movetime_ms) ?? preset?.movetime_ms ?? 200;
   const depth = toPositiveInt(payload.depth) ?? preset?.depth;
   const hash_mb = toPositiveInt(payload.hash_mb) ?? preset?.hash_mb;
+  const elo = toIntInRange(payload.elo, 800, 2800);
+  const skill_level = toIntInRange(payload.skill_level, 0, MAX_SKILL_LEVEL) ?? preset?.skill_level ?? MAX_SKILL_LEVEL;
 
-  return { movetime_ms, depth, hash_mb, skill: skillRaw };
+  return { movetime_ms, depth, hash_mb, skill: skillRaw, skill_level, elo };
 }
 
 app.get("/api/health", (_req, res) => res.json({ ok: true }));
@@ -385,9 +463,12 @@ app.post("/api/move", async (req, res) => {
     finishedAt: null,
     lastInfoAt: null,
     lastInfo: null,
+    infoByMove: new Map(),
     bestmove: null,
     error: null,
     bookhit: null,
+    stats: null,
+    lastIterStats: null,
   };
   requestStates.set(requestId, state);
   cleanupOldStates();
@@ -403,6 +484,11 @@ app.post("/api/move", async (req, res) => {
       const detachBookListener = engineClient.onLine((line) => {
         if (line.startsWith("info string bookhit")) sawBookHit = true;
       });
+      // Si el cliente se va, cortar la búsqueda en vez de esperar todo el movetime
+      const cancelOnClose = () => {
+        if (state.active) engineClient.send("stop");
+      };
+      res.on("close", cancelOnClose);
 
       try {
         if (opts.hash_mb && opts.hash_mb !== currentHashMb) {
@@ -412,12 +498,27 @@ app.post("/api/move", async (req, res) => {
           currentHashMb = opts.hash_mb;
         }
 
+        const strength = strengthCommands(opts);
+        if (strength.join("\n") !== currentStrength) {
+          for (const cmd of strength) engineClient.send(cmd);
+          currentStrength = strength.join("\n");
+        }
+
         engineClient.send(buildPositionCommand({ fen, moves_uci }));
         const go = opts.depth ? `go depth ${opts.depth}` : `go movetime ${numericMoveTime}`;
         engineClient.send(go);
 
         const bestTimeout = Math.max(MOVE_TIMEOUT_MS, numericMoveTime + 4000);
-        const best = await engineClient.waitFor((l) => l.startsWith("bestmove "), bestTimeout, requestId);
+        let best;
+        try {
+          best = await engineClient.waitFor((l) => l.startsWith("bestmove "), bestTimeout, requestId);
+        } catch (error) {
+          if (error?.message !== "engine timeout") throw error;
+          // Consumir el bestmove pendiente para que no se cuele en el próximo request
+          engineClient.send("stop");
+          await engineClient.waitFor((l) => l.startsWith("bestmove "), STOP_GRACE_MS, requestId).catch(() => {});
+          throw error;
+        }
         const uci = best.split(/\s+/)[1] ?? "0000";
 
         state.bestmove = uci;
@@ -428,6 +529,7 @@ app.post("/api/move", async (req, res) => {
         return serializeBestmove(state);
       } finally {
         detachBookListener();
+        res.off("close", cancelOnClose);
       }
     });
 
@@ -451,7 +553,8 @@ app.post("/api/move", async (req, res) => {
 });
 
 app.post("/api/hint", async (req, res) => {
-  if (!stockfishReady) {
+  const useStockfish = HINT_ENGINE === "stockfish";
+  if (useStockfish && !stockfishReady) {
     return res.status(503).json({
       best: null,
       lines: [],
@@ -472,22 +575,41 @@ app.post("/api/hint", async (req, res) => {
   const requestId = randomUUID();
 
   try {
-    const result = await enqueueStockfishTask(async () => {
+    const client = useStockfish ? stockfishClient : engineClient;
+    const enqueue = useStockfish ? enqueueStockfishTask : enqueueEngineTask;
+    const result = await enqueue(async () => {
       const linesByPv = new Map();
-      const detach = stockfishClient.onLine((line) => {
+      const detach = client.onLine((line) => {
         const parsed = parseStockfishMultipv(line);
         if (!parsed) return;
         linesByPv.set(parsed.multipv, parsed);
       });
 
       try {
-        stockfishClient.send(`setoption name MultiPV value ${multipv}`);
-        stockfishClient.send("isready");
-        await stockfishClient.waitFor((l) => l === "readyok", 3000, requestId);
-
-        stockfishClient.send(buildPositionCommand({ fen, moves_uci }));
-        stockfishClient.send(`go movetime ${movetimeMs}`);
-        await stockfishClient.waitFor((l) => l.startsWith("bestmove "), Math.max(HINT_TIMEOUT_MS, movetimeMs + 2500), requestId);
+        // las pistas van siempre a fuerza completa, aunque la partida sea a nivel bajo
+        if (!useStockfish) {
+          const full = strengthCommands({ skill_level: MAX_SKILL_LEVEL });
+          if (full.join("\n") !== currentStrength) {
+            for (const cmd of full) client.send(cmd);
+            currentStrength = full.join("\n");
+          }
+        }
+        client.send(`setoption name MultiPV value ${multipv}`);
+        client.send("isready");
+        await client.waitFor((l) => l === "readyok", 3000, requestId);
+
+        client.send(buildPositionCommand({ fen, moves_uci }));
+        client.send(`go movetime ${movetimeMs}`);
+        try {
+          await client.waitFor((l) => l.startsWith("bestmove "), Math.max(HINT_TIMEOUT_MS, movetimeMs + 2500), requestId);
+        } catch (error) {
+          if (error?.message !== "engine timeout") throw error;
+          // Igual que /api/move: consumir el bestmove pendiente antes de soltar el engine
+          // (y antes de volver a MultiPV 1 en el finally)
+          client.send("stop");
+          await client.waitFor((l) => l.startsWith("bestmove "), STOP_GRACE_MS, requestId).catch(() => {});
+          throw error;
+        }
 
         const lines = [...linesByPv.values()]
           .sort((a, b) => a.multipv - b.multipv)
@@ -499,6 +621,8 @@ app.post("/api/hint", async (req, res) => {
         return { best, lines };
       } finally {
         detach();
+        // bm_engine atiende también /api/move: volver a una sola línea
+        if (!useStockfish) client.send("setoption name MultiPV value 1");
       }
     });
 
@@ -509,12 +633,13 @@ app.post("/api/hint", async (req, res) => {
     if (timeout) return res.json({ best: null, lines: [], timeout: true });
     return res.status(500).json({ error: e?.message ?? "internal error", code: "HINT_ERROR" });
   } finally {
-    stockfishClient.cleanupWaitersForRequest(requestId);
+    (useStockfish ? stockfishClient : engineClient).cleanupWaitersForRequest(requestId);
   }
 });
 
 app.listen(8000, () => {
   console.log("service on http://localhost:8000");
   console.log("engine:", ENGINE_PATH);
-  console.log("stockfish:", STOCKFISH_PATH, stockfishReady ? "(ready)" : "(disabled)");
+  if (stockfishClient) console.log("stockfish:", STOCKFISH_PATH, stockfishReady ? "(ready)" : "(disabled)");
+  else console.log("hints: bm_engine MultiPV");
 });
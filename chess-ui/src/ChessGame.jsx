@@ -3,6 +3,8 @@ import { Chess } from "chess.js";
 import { Chessboard } from "react-chessboard";
 
 const LEVEL_PRESETS = {
+  principiante: { label: "Principiante", skill: "beginner", minMovetimeMs: 300, maxMovetimeMs: 300, depth: undefined, hashMb: 16 },
+  casual: { label: "Casual", skill: "casual", minMovetimeMs: 300, maxMovetimeMs: 300, depth: undefined, hashMb: 32 },
   rapido: { label: "Rápido", skill: "blitz", minMovetimeMs: 150, maxMovetimeMs: 250, depth: undefined, hashMb: 64 },
   medio: { label: "Medio", skill: "rapid", minMovetimeMs: 500, maxMovetimeMs: 800, depth: undefined, hashMb: 96 },
   fuerte: { label: "Fuerte", skill: "strong", minMovetimeMs: 1200, maxMovetimeMs: 2000, depth: 10, hashMb: 192 },
@@ -374,6 +376,8 @@ export default function ChessGame() {
         <label style={{ display: "flex", gap: 8, alignItems: "center" }}>
           Nivel
           <select value={level} onChange={(e) => setLevel(e.target.value)} disabled={thinking}>
+            <option value="principiante">Principiante</option>
+            <option value="casual">Casual</option>
             <option value="rapido">Rápido</option>
             <option value="medio">Medio</option>
             <option value="fuerte">Fuerte</option>
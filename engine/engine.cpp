@@ -0,0 +1,1508 @@
+#include "engine.h"
+
+#include <fstream>
+#include <iomanip>
+#include <random>
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <linux/mempolicy.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#endif
+#if defined(USE_SYZYGY)
+#include "tbprobe.h"
+#endif
+
+// ---------------- Bitboards ----------------
+static const int ROOK_DIRS[4][2]   = { {0,1},{0,-1},{1,0},{-1,0} };
+static const int BISHOP_DIRS[4][2] = { {1,1},{-1,1},{1,-1},{-1,-1} };
+
+// SplitMix64 RNG
+static inline uint64_t splitmix64(uint64_t &x) {
+  uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+// Magics precalculadas con init_magics (semilla fija); si alguna no valida se busca otra.
+static const Bitboard ROOK_MAGIC_SEEDS[64] = {
+  0x3280002014400080ULL, 0x0040002000401000ULL, 0x0980200080285000ULL, 0x2080041002800800ULL,
+  0x0480040002080180ULL, 0x5200920008140010ULL, 0x4080800200008100ULL, 0x2080004031000880ULL,
+  0x8000800040008021ULL, 0x1880400020100040ULL, 0xA401001020010041ULL, 0x0000808008001000ULL,
+  0x2009001100A80024ULL, 0x1002800200800400ULL, 0x4021000100040200ULL, 0x0001000100208042ULL,
+  0x0000228002824000ULL, 0x00148180400C2001ULL, 0x0A80410020081101ULL, 0x0021010010000822ULL,
+  0x0212050011000800ULL, 0x3004004002010040ULL, 0x0091008080020001ULL, 0x0000020004008071ULL,
+  0x0020802080004000ULL, 0x0210004340042004ULL, 0x1045021500402000ULL, 0x0000080080100080ULL,
+  0x0212000A00200490ULL, 0x0008020080040080ULL, 0x0208100402080200ULL, 0x0008240200204081ULL,
+  0x0040102440800480ULL, 0x1100802101004001ULL, 0x0100200101001040ULL, 0x0010800800801002ULL,
+  0x0040040080800800ULL, 0x4000800201801400ULL, 0x0400011004000208ULL, 0x000221008A001054ULL,
+  0x004040048023800AULL, 0x8010002000414000ULL, 0x0021001020010040ULL, 0x000A0210400A0020ULL,
+  0x8852000821120004ULL, 0x2140020004008080ULL, 0x024C011008040002ULL, 0x10804040810E0004ULL,
+  0x0400310040800100ULL, 0x6440400080200080ULL, 0x2218411520010100ULL, 0x1001100100200900ULL,
+  0x0008004200040040ULL, 0x6100020004008080ULL, 0x9208010208100400ULL, 0x1001002210804100ULL,
+  0x1006204281001202ULL, 0x0830204010810202ULL, 0x0D005520000900C1ULL, 0x0120200500100009ULL,
+  0x0042001104082082ULL, 0x9801001400080603ULL, 0x3880008108500204ULL, 0x10A21C0020804102ULL,
+};
+static const Bitboard BISHOP_MAGIC_SEEDS[64] = {
+  0x2008023002021211ULL, 0x10041480A2020120ULL, 0x000401020E002006ULL, 0x8004041080200080ULL,
+  0x2154142010400400ULL, 0x0104442004004208ULL, 0x0292051C42400402ULL, 0x0031220054044008ULL,
+  0x8000400204010230ULL, 0x0024500408008421ULL, 0x2006084620520102ULL, 0x0540040420809200ULL,
+  0x0090020210000020ULL, 0x400002080A1A3102ULL, 0x0A402CA410021050ULL, 0x0000020202112420ULL,
+  0x0440182014012640ULL, 0x1021060224010210ULL, 0x44100882042208A0ULL, 0x0008002404101000ULL,
+  0x204E102401200128ULL, 0x042A001100920100ULL, 0x0041100841101002ULL, 0x08022302020A0240ULL,
+  0x01A0105820040180ULL, 0x0082900252901600ULL, 0x0400220630048200ULL, 0x0000848008020140ULL,
+  0x9404820004010400ULL, 0x0004090001900190ULL, 0x2108009020420800ULL, 0x0200820422824430ULL,
+  0x0010080900045081ULL, 0x0208148408700105ULL, 0x0004104800440800ULL, 0x0830300820040400ULL,
+  0x0100540400004100ULL, 0x0009012A00030800ULL, 0x2002085044010400ULL, 0x0024088085021440ULL,
+  0xC190B82030018840ULL, 0x0220480404001102ULL, 0x0050840048040100ULL, 0x0940012018004503ULL,
+  0x020424409200C400ULL, 0x2001100100402A04ULL, 0x0490100240800048ULL, 0x8010011A00830230ULL,
+  0x00A6051042100040ULL, 0x1008310808045460ULL, 0x00012206251C0014ULL, 0x02002100840401C0ULL,
+  0x0261001042020000ULL, 0x8C08088208020281ULL, 0x12A1200208C10080ULL, 0x11041010A1010000ULL,
+  0x1111008041201002ULL, 0x224C020244442400ULL, 0x2040000640441080ULL, 0x008110045020A800ULL,
+  0x00108182C0050102ULL, 0x0004004628900100ULL, 0x109020142408C410ULL, 0x0008820408020214ULL,
+};
+
+// Recorrido de rayos lento: solo se usa para llenar las tablas al arrancar.
+static Bitboard sliding_attacks(int sq, Bitboard occ, const int dirs[4][2]) {
+  Bitboard att = 0;
+  for (int d = 0; d < 4; d++) {
+    int f = file_of(sq) + dirs[d][0], r = rank_of(sq) + dirs[d][1];
+    while (on_board(f, r)) {
+      int s = sq_of(f, r);
+      att |= bb_sq(s);
+      if (occ & bb_sq(s)) break;
+      f += dirs[d][0]; r += dirs[d][1];
+    }
+  }
+  return att;
+}
+
+static void init_magics(array<Magic, 64>& magics, Bitboard* table, const int dirs[4][2],
+                        const Bitboard* seeds) {
+  uint64_t seed = 0x5EEDB17B0A4Dull; // fijo: mismas magics (y mismo layout) en cada arranque
+  array<Bitboard, 4096> occs, refs;
+  array<int, 4096> epoch{};
+  int cnt = 0;
+
+  Bitboard* next = table;
+  for (int sq = 0; sq < 64; sq++) {
+    Magic& m = magics[sq];
+    Bitboard edges = ((RANK_1_BB | RANK_8_BB) & ~rank_bb(rank_of(sq))) |
+                     ((FILE_A_BB | FILE_H_BB) & ~file_bb(file_of(sq)));
+    m.mask = sliding_attacks(sq, 0, dirs) & ~edges;
+    m.shift = 64 - popcnt(m.mask);
+    m.attacks = next;
+
+    // Enumerar todos los subconjuntos de la máscara (carry-rippler)
+    int n = 0;
+    Bitboard b = 0;
+    do {
+      occs[n] = b;
+      refs[n] = sliding_attacks(sq, b, dirs);
+      n++;
+      b = (b - m.mask) & m.mask;
+    } while (b);
+    next += n;
+
+#if defined(USE_PEXT)
+    for (int i = 0; i < n; i++) m.attacks[m.index(occs[i])] = refs[i];
+#else
+    m.magic = seeds[sq];
+    for (bool first = true; ; first = false) {
+      if (!first || m.magic == 0) {
+        do {
+          m.magic = splitmix64(seed) & splitmix64(seed) & splitmix64(seed);
+        } while (popcnt((m.magic * m.mask) >> 56) < 6);
+      }
+
+      cnt++;
+      int i = 0;
+      for (; i < n; i++) {
+        unsigned idx = m.index(occs[i]);
+        if (epoch[idx] < cnt) {
+          epoch[idx] = cnt;
+          m.attacks[idx] = refs[i];
+        } else if (m.attacks[idx] != refs[i]) {
+          break; // colisión destructiva: probar otra magic
+        }
+      }
+      if (i == n) break;
+    }
+#endif
+  }
+}
+
+void init_attack_tables() {
+  for (int sq = 0; sq < 64; sq++) {
+    int f = file_of(sq), r = rank_of(sq);
+
+    static const int kdf[8] = { -2,-1, 1, 2, 2, 1,-1,-2 };
+    static const int kdr[8] = {  1, 2, 2, 1,-1,-2,-2,-1 };
+    for (int i = 0; i < 8; i++) {
+      int nf = f + kdf[i], nr = r + kdr[i];
+      if (on_board(nf, nr)) KNIGHT_ATT[sq] |= bb_sq(sq_of(nf, nr));
+    }
+
+    for (int df = -1; df <= 1; df++) {
+      for (int dr = -1; dr <= 1; dr++) {
+        if (df == 0 && dr == 0) continue;
+        int nf = f + df, nr = r + dr;
+        if (on_board(nf, nr)) KING_ATT[sq] |= bb_sq(sq_of(nf, nr));
+      }
+    }
+
+    if (on_board(f - 1, r + 1)) PAWN_ATT[WHITE][sq] |= bb_sq(sq_of(f - 1, r + 1));
+    if (on_board(f + 1, r + 1)) PAWN_ATT[WHITE][sq] |= bb_sq(sq_of(f + 1, r + 1));
+    if (on_board(f - 1, r - 1)) PAWN_ATT[BLACK][sq] |= bb_sq(sq_of(f - 1, r - 1));
+    if (on_board(f + 1, r - 1)) PAWN_ATT[BLACK][sq] |= bb_sq(sq_of(f + 1, r - 1));
+  }
+
+  init_magics(ROOK_MAGICS, ROOK_TABLE.data(), ROOK_DIRS, ROOK_MAGIC_SEEDS);
+  init_magics(BISHOP_MAGICS, BISHOP_TABLE.data(), BISHOP_DIRS, BISHOP_MAGIC_SEEDS);
+
+  for (int a = 0; a < 64; a++) {
+    for (int b = 0; b < 64; b++) {
+      BETWEEN_BB[a][b] = LINE_BB[a][b] = 0;
+      if (a == b) continue;
+      if (rook_attacks(a, 0) & bb_sq(b)) {
+        BETWEEN_BB[a][b] = rook_attacks(a, bb_sq(b)) & rook_attacks(b, bb_sq(a));
+        LINE_BB[a][b] = (rook_attacks(a, 0) & rook_attacks(b, 0)) | bb_sq(a) | bb_sq(b);
+      } else if (bishop_attacks(a, 0) & bb_sq(b)) {
+        BETWEEN_BB[a][b] = bishop_attacks(a, bb_sq(b)) & bishop_attacks(b, bb_sq(a));
+        LINE_BB[a][b] = (bishop_attacks(a, 0) & bishop_attacks(b, 0)) | bb_sq(a) | bb_sq(b);
+      }
+    }
+  }
+}
+
+// ---------------- Zobrist ----------------
+void init_zobrist(uint64_t seed) {
+  uint64_t x = seed;
+  for (int i = 0; i < 12; i++)
+    for (int sq = 0; sq < 64; sq++)
+      Z_PIECE[i][sq] = splitmix64(x);
+
+  for (int i = 0; i < 16; i++) Z_CASTLE[i] = splitmix64(x);
+  for (int i = 0; i < 8; i++)  Z_EPFILE[i] = splitmix64(x);
+  Z_SIDE = splitmix64(x);
+}
+
+// ---------------- Perft ----------------
+// Cache opcional (key, depth) -> nodos, compartido entre threads sin locks:
+// cada entrada guarda nodes y key^salt^nodes; una lectura rota no valida.
+struct PerftEntry {
+  atomic<uint64_t> check{0};
+  atomic<uint64_t> nodes{0};
+};
+
+struct PerftTable {
+  unique_ptr<PerftEntry[]> t;
+  size_t count = 0;
+
+  explicit PerftTable(int mb) {
+    if (mb <= 0) return;
+    count = (size_t)mb * 1024ULL * 1024ULL / sizeof(PerftEntry);
+    t.reset(new PerftEntry[count]);
+  }
+
+  static uint64_t salt(uint64_t key, int depth) { return key ^ ((uint64_t)depth * 0x9E3779B97F4A7C15ULL); }
+
+  bool probe(uint64_t key, int depth, uint64_t& nodes) const {
+    if (!count) return false;
+    uint64_t k = salt(key, depth);
+    const PerftEntry& e = t[k % count];
+    uint64_t n = e.nodes.load(memory_order_relaxed);
+    if ((e.check.load(memory_order_relaxed) ^ n) != k) return false;
+    nodes = n;
+    return true;
+  }
+
+  void store(uint64_t key, int depth, uint64_t nodes) {
+    if (!count) return;
+    uint64_t k = salt(key, depth);
+    PerftEntry& e = t[k % count];
+    e.nodes.store(nodes, memory_order_relaxed);
+    e.check.store(k ^ nodes, memory_order_relaxed);
+  }
+};
+
+// depth 1: bulk counting (cantidad de jugadas legales, sin hacerlas)
+static uint64_t perft(Board& b, int depth, PerftTable* tt = nullptr) {
+  if (depth == 0) return 1ULL;
+  MoveList moves;
+  b.gen_legal(moves);
+  if (depth == 1) return (uint64_t)moves.size();
+
+  uint64_t cached;
+  if (tt && tt->probe(b.key, depth, cached)) return cached;
+
+  uint64_t nodes = 0;
+  for (const auto& m : moves) {
+    Undo u;
+    b.make_move(m, u);
+    nodes += perft(b, depth - 1, tt);
+    b.unmake_move(m, u);
+  }
+  if (tt) tt->store(b.key, depth, nodes);
+  return nodes;
+}
+
+// Reparte las jugadas de la raíz entre threads (cada uno con su copia del Board).
+// perMove: nodos por jugada de la raíz, en el orden de gen_legal (para divide).
+uint64_t perft_parallel(const Board& root, int depth, int threads, int hashMb,
+                        vector<pair<Move, uint64_t>>* perMove) {
+  MoveList moves;
+  root.gen_legal(moves);
+  if (depth <= 1) {
+    if (perMove) for (const auto& m : moves) perMove->push_back({m, 1});
+    return depth == 0 ? 1ULL : (uint64_t)moves.size();
+  }
+
+  PerftTable tt(hashMb);
+  vector<uint64_t> counts(moves.size(), 0);
+  atomic<int> next{0};
+  auto worker = [&]() {
+    Board b = root;
+    for (int i; (i = next.fetch_add(1)) < moves.size(); ) {
+      Undo u;
+      b.make_move(moves[i], u);
+      counts[i] = perft(b, depth - 1, tt.count ? &tt : nullptr);
+      b.unmake_move(moves[i], u);
+    }
+  };
+
+  int n = max(1, min(threads, moves.size()));
+  vector<thread> pool;
+  for (int i = 1; i < n; i++) pool.emplace_back(worker);
+  worker();
+  for (auto& t : pool) t.join();
+
+  uint64_t total = 0;
+  for (int i = 0; i < moves.size(); i++) {
+    total += counts[i];
+    if (perMove) perMove->push_back({moves[i], counts[i]});
+  }
+  return total;
+}
+
+void perft_divide(const Board& b, int depth, int threads, int hashMb) {
+  vector<pair<Move, uint64_t>> perMove;
+  uint64_t total = perft_parallel(b, depth, threads, hashMb, &perMove);
+  for (const auto& [m, n] : perMove) cout << move_to_uci(m) << ": " << n << "\n";
+  cout << "Total: " << total << "\n";
+}
+
+
+// Salida UCI: el thread de búsqueda y el loop principal escriben líneas
+// completas, nunca intercaladas.
+// Un flush por línea (unitbuf) pesa con muchas sesiones en paralelo o
+// iteraciones cortas: las "info" se vuelcan como mucho cada INFO_FLUSH_MS (y
+// la búsqueda vuelca al terminar cada depth).
+static constexpr int64_t INFO_FLUSH_MS = 20;
+static mutex UCI_OUT_MUTEX;
+static chrono::steady_clock::time_point UCI_LAST_FLUSH;
+
+void uci_send(const string& line, bool flush) {
+  lock_guard<mutex> lock(UCI_OUT_MUTEX);
+  if (UCI_OUTPUT_HOOK) { UCI_OUTPUT_HOOK(line); return; }
+  cout << line << '\n';
+  auto now = chrono::steady_clock::now();
+  if (flush || now - UCI_LAST_FLUSH >= chrono::milliseconds(INFO_FLUSH_MS)) {
+    cout.flush();
+    UCI_LAST_FLUSH = now;
+  }
+}
+
+void uci_flush() {
+  lock_guard<mutex> lock(UCI_OUT_MUTEX);
+  cout.flush();
+  UCI_LAST_FLUSH = chrono::steady_clock::now();
+}
+
+
+// ---------------- Eval ----------------
+// pawn structure: doubled + isolated (simple)
+static int pawn_structure(Bitboard wp, Bitboard bp) {
+  int score = 0;
+  for (int f = 0; f < 8; f++) {
+    int wn = popcnt(wp & file_bb(f));
+    int bn = popcnt(bp & file_bb(f));
+    if (wn >= 2) score -= 10 * (wn - 1);
+    if (bn >= 2) score += 10 * (bn - 1);
+
+    if (wn && !(wp & adjacent_files_bb(f))) score -= 8;
+    if (bn && !(bp & adjacent_files_bb(f))) score += 8;
+  }
+  return score;
+}
+
+int eval(const Board& b, PawnTable& pawns) {
+  if (NNUE_ON) return nnue_evaluate(b.acc, b.side);
+
+  int ph = min(b.phase, PHASE_MAX);
+  int score = (b.psq_mg * ph + b.psq_eg * (PHASE_MAX - ph)) / PHASE_MAX;
+
+  // bishop pair
+  if (popcnt(b.pieces[WHITE][BISHOP]) >= 2) score += 25;
+  if (popcnt(b.pieces[BLACK][BISHOP]) >= 2) score -= 25;
+
+  PawnEntry& pe = pawns[b.pawn_key];
+  if (pe.key != b.pawn_key) {
+    pe.key = b.pawn_key;
+    pe.score = pawn_structure(b.pieces[WHITE][PAWN], b.pieces[BLACK][PAWN]);
+  }
+  score += pe.score;
+
+  // king safety: bonus por enrocar; penalización si no enrocó “tarde”
+  constexpr Bitboard W_CASTLED = bb_sq(6) | bb_sq(2);    // g1, c1
+  constexpr Bitboard B_CASTLED = bb_sq(62) | bb_sq(58);  // g8, c8
+  if (Bitboard wk = b.pieces[WHITE][KING]) {
+    if (wk & W_CASTLED) score += 18;
+    else if (b.fullmove >= 10) score -= 18;
+  }
+  if (Bitboard bk = b.pieces[BLACK][KING]) {
+    if (bk & B_CASTLED) score -= 18;
+    else if (b.fullmove >= 10) score += 18;
+  }
+
+  // no salir con la dama demasiado temprano (suave)
+  if (b.fullmove <= 8) {
+    if (b.pieces[WHITE][QUEEN] & bb_sq(3)) score -= 8;   // d1
+    if (b.pieces[BLACK][QUEEN] & bb_sq(59)) score += 8;  // d8
+  }
+
+  // perspectiva del que mueve (negamax)
+  return (b.side == WHITE) ? score : -score;
+}
+
+
+// ---------------- Large-page memory ----------------
+#if defined(__linux__)
+// Nodos NUMA online según sysfs ("0", "0-3", "0,2-3"); 1 si no se puede leer.
+static int numa_node_count() {
+  ifstream in("/sys/devices/system/node/online");
+  string spec;
+  if (!(in >> spec)) return 1;
+  int maxNode = 0;
+  for (auto& c : spec) if (c == ',' || c == '-') c = ' ';
+  istringstream iss(spec);
+  for (int n; iss >> n; ) maxNode = max(maxNode, n);
+  return maxNode + 1;
+}
+
+static void numa_interleave(void* p, size_t len) {
+  static const int nodes = numa_node_count();
+  if (nodes <= 1 || nodes > 64) return;
+  unsigned long mask = (nodes == 64) ? ~0UL : ((1UL << nodes) - 1);
+  // best effort: si el kernel no tiene NUMA, mbind falla y queda first-touch
+  syscall(SYS_mbind, p, len, MPOL_INTERLEAVE, &mask, (unsigned long)nodes + 1, 0);
+}
+#endif
+
+LargeBlock large_alloc(size_t bytes) {
+  LargeBlock blk;
+#if defined(__linux__)
+  constexpr size_t HUGE_PAGE = 2ULL * 1024 * 1024;
+  size_t len = (bytes + HUGE_PAGE - 1) / HUGE_PAGE * HUGE_PAGE;
+  void* p = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  if (p == MAP_FAILED) {
+    p = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p != MAP_FAILED) madvise(p, len, MADV_HUGEPAGE);
+  }
+  if (p != MAP_FAILED) {
+    numa_interleave(p, len);
+    blk.ptr = p;
+    blk.bytes = len;
+    blk.mmapped = true;
+    return blk;
+  }
+#endif
+  blk.bytes = (bytes + 63) / 64 * 64;
+  blk.ptr = aligned_alloc(64, blk.bytes);
+  if (!blk.ptr) blk.bytes = 0;
+  return blk;
+}
+
+void large_free(LargeBlock& blk) {
+  if (!blk.ptr) return;
+#if defined(__linux__)
+  if (blk.mmapped) munmap(blk.ptr, blk.bytes);
+  else free(blk.ptr);
+#else
+  free(blk.ptr);
+#endif
+  blk = LargeBlock{};
+}
+
+// memset repartido entre threads: acelera setoption Hash grandes y, con
+// first-touch / interleave, distribuye las páginas entre nodos.
+void parallel_zero(void* p, size_t bytes) {
+  const size_t MIN_CHUNK = 16ULL * 1024 * 1024;
+  size_t n = HAS_THREADS ? min<size_t>(max(1u, thread::hardware_concurrency()), 32) : 1;
+  n = max<size_t>(1, min(n, bytes / MIN_CHUNK));
+  size_t chunk = (bytes / n + 63) / 64 * 64;
+
+  vector<thread> workers;
+  for (size_t i = 1; i < n; i++) {
+    size_t off = i * chunk;
+    if (off >= bytes) break;
+    workers.emplace_back([=]() { memset((char*)p + off, 0, min(chunk, bytes - off)); });
+  }
+  memset(p, 0, min(chunk, bytes));
+  for (auto& w : workers) w.join();
+}
+
+// ---------------- Syzygy ----------------
+// Scores de tabla: debajo del rango de mate (is_mate_score) para no mezclar
+// "gana según la tabla" con una distancia a mate.
+static constexpr int TB_WIN_SCORE = 20000;
+
+#if defined(USE_SYZYGY)
+static mutex TB_ROOT_MUTEX;          // tb_probe_root de Fathom no es thread-safe
+
+int syzygy_init(const string& path) {
+  tb_free();
+  if (path.empty() || path == "<empty>") return 0;
+  if (!tb_init(path.c_str())) return 0;
+  return (int)TB_LARGEST;
+}
+
+int syzygy_largest() { return (int)TB_LARGEST; }
+
+static int tb_score(unsigned wdl, int ply) {
+  switch (wdl) {
+    case TB_WIN:          return TB_WIN_SCORE - ply;
+    case TB_LOSS:         return -TB_WIN_SCORE + ply;
+    case TB_CURSED_WIN:   return 1;    // gana, pero la regla de 50 lo hace tablas
+    case TB_BLESSED_LOSS: return -1;
+    default:              return 0;
+  }
+}
+
+static unsigned tb_probe(const Board& b, unsigned* rootResults) {
+  const auto& W = b.pieces[WHITE];
+  const auto& B = b.pieces[BLACK];
+  uint64_t white = b.occ[WHITE], black = b.occ[BLACK];
+  unsigned ep = b.ep < 0 ? 0 : (unsigned)b.ep;
+  bool turn = b.side == WHITE;
+  if (rootResults)
+    return tb_probe_root(white, black, W[KING] | B[KING], W[QUEEN] | B[QUEEN], W[ROOK] | B[ROOK],
+                         W[BISHOP] | B[BISHOP], W[KNIGHT] | B[KNIGHT], W[PAWN] | B[PAWN],
+                         (unsigned)b.halfmove, (unsigned)b.castling, ep, turn, rootResults);
+  return tb_probe_wdl(white, black, W[KING] | B[KING], W[QUEEN] | B[QUEEN], W[ROOK] | B[ROOK],
+                      W[BISHOP] | B[BISHOP], W[KNIGHT] | B[KNIGHT], W[PAWN] | B[PAWN],
+                      0, 0, ep, turn);
+}
+
+// WDL en búsqueda: Fathom solo responde sin enroques y con halfmove == 0
+// (justo después de captura o jugada de peón, que es cuando cambia la tabla).
+static bool syzygy_probe_wdl(const Board& b, int ply, int& score) {
+  if (b.castling || b.halfmove) return false;
+  unsigned r = tb_probe(b, nullptr);
+  if (r == TB_RESULT_FAILED) return false;
+  score = tb_score(r, ply);
+  return true;
+}
+
+// Raíz: la jugada que preserva el resultado con la mejor DTZ (respeta la regla
+// de 50 jugadas), sin buscar.
+static bool syzygy_root_move(const Board& b, Move& best, int& score) {
+  if (b.castling || popcnt(b.occupied()) > syzygy_largest()) return false;
+  unsigned r;
+  {
+    lock_guard<mutex> lock(TB_ROOT_MUTEX);
+    unsigned results[TB_MAX_MOVES];
+    r = tb_probe(b, results);
+  }
+  if (r == TB_RESULT_FAILED || r == TB_RESULT_CHECKMATE || r == TB_RESULT_STALEMATE) return false;
+
+  static constexpr int PROMO[5] = {EMPTY, QUEEN, ROOK, BISHOP, KNIGHT};
+  int from = (int)TB_GET_FROM(r), to = (int)TB_GET_TO(r), promo = PROMO[TB_GET_PROMOTES(r)];
+  MoveList legal;
+  b.gen_legal(legal);
+  for (const auto& m : legal) {
+    if (m.from() == from && m.to() == to && m.promo() == promo) {
+      best = m;
+      score = tb_score(TB_GET_WDL(r), 0);
+      return true;
+    }
+  }
+  return false;
+}
+#else
+int syzygy_init(const string&) { return 0; }
+int syzygy_largest() { return 0; }
+static bool syzygy_probe_wdl(const Board&, int, int&) { return false; }
+static bool syzygy_root_move(const Board&, Move&, int&) { return false; }
+#endif
+
+// ---------------- Cache persistente ----------------
+// Archivo: cabecera de 64 bytes + clusters de 4 entradas (key ^ data, data).
+// data: jugada (16) | score (16) | depth (8) | bound (8) | ocupada (bit 48).
+struct SearchCacheHeader {
+  char magic[8];            // "BMSCACHE"
+  uint32_t version;
+  uint32_t ways;
+  uint64_t clusters;        // potencia de 2
+  uint64_t zobrist_check;   // key de la posición inicial: otras Zobrist, otro archivo
+};
+static_assert(sizeof(SearchCacheHeader) <= 64, "la cabecera del cache entra en 64 bytes");
+
+static constexpr uint32_t SEARCH_CACHE_VERSION = 1;
+static constexpr int SEARCH_CACHE_WAYS = 4;
+static constexpr size_t SEARCH_CACHE_HEADER = 64;
+static constexpr size_t SEARCH_CACHE_CLUSTER = SEARCH_CACHE_WAYS * 2 * sizeof(uint64_t);
+static constexpr uint64_t SEARCH_CACHE_USED = 1ULL << 48;
+
+static void* SEARCH_CACHE_MAP = nullptr;
+static size_t SEARCH_CACHE_BYTES = 0;
+static uint64_t* SEARCH_CACHE_SLOTS = nullptr;
+static uint64_t SEARCH_CACHE_MASK = 0;
+
+static uint64_t cache_pack(const CachedResult& r) {
+  return (uint64_t)r.best.data | ((uint64_t)(uint16_t)(int16_t)r.score << 16) |
+         ((uint64_t)(uint8_t)min(r.depth, 255) << 32) | ((uint64_t)r.bound << 40) | SEARCH_CACHE_USED;
+}
+
+static CachedResult cache_unpack(uint64_t d) {
+  CachedResult r;
+  r.best.data = (uint16_t)d;
+  r.score = (int16_t)(uint16_t)(d >> 16);
+  r.depth = (uint8_t)(d >> 32);
+  r.bound = (TTFlag)(uint8_t)(d >> 40);
+  return r;
+}
+
+static uint64_t* cache_cluster(uint64_t key) {
+  return SEARCH_CACHE_SLOTS + (key & SEARCH_CACHE_MASK) * SEARCH_CACHE_WAYS * 2;
+}
+
+bool search_cache_is_open() { return SEARCH_CACHE_SLOTS != nullptr; }
+
+#if defined(__linux__)
+static_assert(atomic_ref<uint64_t>::is_always_lock_free, "el cache compartido necesita atómicos de 64 bits");
+
+bool search_cache_open(const string& path, int mb, string& err) {
+  search_cache_close();
+  int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (fd < 0) { err = string("cannot open: ") + strerror(errno); return false; }
+  flock(fd, LOCK_EX);   // un solo proceso crea / valida el archivo a la vez
+
+  Board start;
+  start.set_startpos();
+  struct stat sb{};
+  fstat(fd, &sb);
+  SearchCacheHeader h{};
+  bool ok = true;
+  if (sb.st_size == 0) {
+    // nuevo: clusters en potencia de 2 que entren en 'mb'
+    uint64_t clusters = 1;
+    while (clusters * 2 * SEARCH_CACHE_CLUSTER <= (uint64_t)max(1, mb) * 1024 * 1024) clusters *= 2;
+    memcpy(h.magic, "BMSCACHE", 8);
+    h.version = SEARCH_CACHE_VERSION;
+    h.ways = SEARCH_CACHE_WAYS;
+    h.clusters = clusters;
+    h.zobrist_check = start.key;
+    ok = ftruncate(fd, (off_t)(SEARCH_CACHE_HEADER + clusters * SEARCH_CACHE_CLUSTER)) == 0 &&
+         pwrite(fd, &h, sizeof(h), 0) == (ssize_t)sizeof(h);
+    if (!ok) err = string("cannot create: ") + strerror(errno);
+  } else {
+    // existente: se respeta su tamaño (otros procesos lo tienen mapeado así);
+    // si no coincide el formato no se toca
+    ok = pread(fd, &h, sizeof(h), 0) == (ssize_t)sizeof(h) && memcmp(h.magic, "BMSCACHE", 8) == 0 &&
+         h.version == SEARCH_CACHE_VERSION && h.ways == SEARCH_CACHE_WAYS && h.clusters &&
+         !(h.clusters & (h.clusters - 1)) && h.zobrist_check == start.key &&
+         (uint64_t)sb.st_size == SEARCH_CACHE_HEADER + h.clusters * SEARCH_CACHE_CLUSTER;
+    if (!ok) err = "incompatible file (other version or corrupt)";
+  }
+
+  size_t bytes = SEARCH_CACHE_HEADER + h.clusters * SEARCH_CACHE_CLUSTER;
+  void* p = ok ? mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+  if (ok && p == MAP_FAILED) err = string("mmap: ") + strerror(errno);
+  flock(fd, LOCK_UN);
+  ::close(fd);   // el mapeo sigue vivo sin el descriptor
+  if (p == MAP_FAILED) return false;
+
+  SEARCH_CACHE_MAP = p;
+  SEARCH_CACHE_BYTES = bytes;
+  SEARCH_CACHE_SLOTS = reinterpret_cast<uint64_t*>(static_cast<char*>(p) + SEARCH_CACHE_HEADER);
+  SEARCH_CACHE_MASK = h.clusters - 1;
+  return true;
+}
+
+void search_cache_close() {
+  if (!SEARCH_CACHE_MAP) return;
+  munmap(SEARCH_CACHE_MAP, SEARCH_CACHE_BYTES);
+  SEARCH_CACHE_MAP = nullptr;
+  SEARCH_CACHE_SLOTS = nullptr;
+  SEARCH_CACHE_BYTES = 0;
+  SEARCH_CACHE_MASK = 0;
+}
+#else
+bool search_cache_open(const string&, int, string& err) { err = "not supported on this platform"; return false; }
+void search_cache_close() {}
+#endif
+
+bool search_cache_probe(const Board& b, int minDepth, CachedResult& out) {
+  if (!SEARCH_CACHE_SLOTS || b.halfmove >= 50) return false;
+  uint64_t* c = cache_cluster(b.key);
+  for (int w = 0; w < SEARCH_CACHE_WAYS; w++) {
+    uint64_t data = atomic_ref<uint64_t>(c[2 * w + 1]).load(memory_order_relaxed);
+    uint64_t kx = atomic_ref<uint64_t>(c[2 * w]).load(memory_order_relaxed);
+    if (!(data & SEARCH_CACHE_USED) || (kx ^ data) != b.key) continue;
+    CachedResult r = cache_unpack(data);
+    if (r.depth < minDepth || !b.is_legal(r.best)) return false;
+    out = r;
+    return true;
+  }
+  return false;
+}
+
+// Reemplazo: la misma posición solo con depth >= la guardada; si no, la de menor depth del cluster
+void search_cache_store(const Board& b, const CachedResult& r) {
+  if (!SEARCH_CACHE_SLOTS || b.halfmove >= 50 || r.depth <= 0 || r.best.is_null()) return;
+  uint64_t* c = cache_cluster(b.key);
+  int victim = 0, victimDepth = INT_MAX;
+  for (int w = 0; w < SEARCH_CACHE_WAYS; w++) {
+    uint64_t data = atomic_ref<uint64_t>(c[2 * w + 1]).load(memory_order_relaxed);
+    uint64_t kx = atomic_ref<uint64_t>(c[2 * w]).load(memory_order_relaxed);
+    int depth = (data & SEARCH_CACHE_USED) ? (int)(uint8_t)(data >> 32) : -1;
+    if ((data & SEARCH_CACHE_USED) && (kx ^ data) == b.key) {
+      if (depth > r.depth) return;
+      victim = w;
+      break;
+    }
+    if (depth < victimDepth) { victim = w; victimDepth = depth; }
+  }
+  uint64_t data = cache_pack(r);
+  atomic_ref<uint64_t>(c[2 * victim + 1]).store(data, memory_order_relaxed);
+  atomic_ref<uint64_t>(c[2 * victim]).store(b.key ^ data, memory_order_relaxed);
+}
+
+// ---------------- Search ----------------
+static constexpr int MAX_PLY = 128;
+
+// Late move reductions: LMR_TABLE[depth][moveCount] ~ ln(d) * ln(m) / 2
+static array<array<int8_t, 64>, 64> LMR_TABLE;
+
+void init_search_tables() {
+  for (int d = 1; d < 64; d++)
+    for (int m = 1; m < 64; m++)
+      LMR_TABLE[d][m] = (int8_t)(0.75 + log((double)d) * log((double)m) / 2.0);
+}
+
+// Pruning/extensiones (centipawns)
+static constexpr int RFP_MAX_DEPTH = 6;
+static constexpr int RFP_MARGIN = 90;       // por ply
+static constexpr int RAZOR_MAX_DEPTH = 2;
+static constexpr int RAZOR_MARGIN = 300;    // por ply
+static constexpr int NULL_MIN_DEPTH = 3;
+static constexpr int HISTORY_LMR_DIV = 2048;
+static constexpr int DELTA_MARGIN = 200;
+
+// Contadores por thread (sin atomics: solo los escribe su thread, se suman al
+// final). Sin SEARCH_STATS, STAT() desaparece y los campos quedan en 0.
+struct SearchStats {
+  uint64_t qnodes = 0;
+  uint64_t tt_probes = 0, tt_hits = 0, tt_cuts = 0;
+  uint64_t fail_high = 0, fail_high_first = 0;   // cortes beta / con la primera jugada
+  uint64_t asp_researches = 0;
+
+  void add(const SearchStats& o) {
+    qnodes += o.qnodes;
+    tt_probes += o.tt_probes; tt_hits += o.tt_hits; tt_cuts += o.tt_cuts;
+    fail_high += o.fail_high; fail_high_first += o.fail_high_first;
+    asp_researches += o.asp_researches;
+  }
+};
+
+#if defined(SEARCH_STATS)
+#define STAT(st, field) (++(st).stats.field)
+#else
+#define STAT(st, field) ((void)0)
+#endif
+
+static double pct(uint64_t a, uint64_t b) { return b ? 100.0 * (double)a / (double)b : 0.0; }
+
+// "qshare 41.2 tthit 35.1 ttcut 12.0 fhfirst 91.3 aspfail 2" (porcentajes)
+static string format_stats(const SearchStats& s, uint64_t nodes) {
+  ostringstream o;
+  o << fixed << setprecision(1)
+    << "qshare " << pct(s.qnodes, nodes)
+    << " tthit " << pct(s.tt_hits, s.tt_probes)
+    << " ttcut " << pct(s.tt_cuts, s.tt_probes)
+    << " fhfirst " << pct(s.fail_high_first, s.fail_high)
+    << " aspfail " << s.asp_researches;
+  return o.str();
+}
+
+struct SearchState {
+  int id = 0;                               // 0 = thread principal (imprime info)
+  const SearchControl* ctl = nullptr;       // límites pedidos por el llamador (UCI)
+  atomic<bool>* stop_flag = nullptr;        // único flag de corte, compartido por todos los threads
+  atomic<uint64_t>* shared_nodes = nullptr; // nodos de todos los threads, en lotes de POLL_NODES
+  TranspositionTable* tt = nullptr;         // TT de la búsqueda (la global salvo ctl.tt)
+  atomic<uint64_t> nodes{0};                // solo lo escribe su thread; los demás leen para nps
+  int seldepth = 0;                         // ply máximo alcanzado (incluye qsearch)
+  int completed_depth = 0;                  // última iteración terminada (sin cortar por tiempo)
+  int tb_pieces = 0;                        // cortes por Syzygy con <= tb_pieces piezas (0 = no)
+  atomic<uint64_t> tb_hits{0};
+  SearchStats stats;
+
+  // PV triangular: pv[ply][ply..pv_len[ply]) es la variante desde ply
+  array<array<Move, MAX_PLY>, MAX_PLY> pv;
+  array<int, MAX_PLY> pv_len{};
+  MoveList excluded;                        // MultiPV: jugadas de raíz ya reportadas en este depth
+
+  void update_pv(int ply, Move m) {
+    pv[ply][ply] = m;
+    int end = (ply + 1 < MAX_PLY) ? pv_len[ply + 1] : ply + 1;
+    for (int i = ply + 1; i < end; i++) pv[ply][i] = pv[ply + 1][i];
+    pv_len[ply] = max(end, ply + 1);
+  }
+
+  // killer moves: [ply][2]
+  array<array<Move, 2>, MAX_PLY> killers{};
+  // history: [color][from][to]
+  array<array<array<int, 64>, 64>, 2> history{};
+  PawnTable pawns;
+
+  // El reloj (y stop / go nodes) se consulta cada POLL_NODES nodos, no en cada
+  // nodo; quien detecta el límite levanta stop_flag y el resto lo ve al instante.
+  static constexpr uint64_t POLL_NODES = 1024;
+
+  void add_node() {
+    uint64_t n = nodes.load(memory_order_relaxed) + 1;
+    nodes.store(n, memory_order_relaxed);
+    if ((n & (POLL_NODES - 1)) == 0) poll();
+  }
+
+  void poll() {
+    uint64_t total = shared_nodes->fetch_add(POLL_NODES, memory_order_relaxed) + POLL_NODES;
+    if (!ctl) return;
+    uint64_t limit = ctl->node_limit.load(memory_order_relaxed);
+    if (ctl->expired() || (limit && total >= limit)) stop_flag->store(true, memory_order_relaxed);
+  }
+
+  bool time_up() const { return stop_flag->load(memory_order_relaxed); }
+};
+
+static int mvv_lva(const Board& b, const Move& m) {
+  int8_t att = b.sq[m.from()];
+  int8_t vic = b.sq[m.to()];
+  if (m.is_enpassant()) vic = (int8_t)(b.side == WHITE ? -PAWN : PAWN);
+  int av = PV[abs_piece(att)];
+  int vv = PV[abs_piece(vic)];
+  return vv * 10 - av;
+}
+
+// Selector de jugadas por etapas: TT -> capturas buenas (MVV-LVA, SEE >= 0) ->
+// killers -> quietas (history) -> capturas malas. Cada etapa se genera recién cuando se agota la anterior y se elige
+// por selección, así la mayoría de los cortes ocurren sin generar quietas.
+// En jaque: TT -> evasiones (capturas primero por MVV-LVA, después quietas por history).
+enum PickStage : int {
+  STAGE_TT, STAGE_GEN_CAPTURES, STAGE_GOOD_CAPTURES, STAGE_KILLER1, STAGE_KILLER2,
+  STAGE_GEN_QUIETS, STAGE_QUIETS, STAGE_BAD_CAPTURES,
+  STAGE_EVASION_TT, STAGE_GEN_EVASIONS, STAGE_EVASIONS, STAGE_DONE
+};
+
+static constexpr int EVASION_CAPTURE_SCORE = 1 << 28;   // por encima de cualquier history
+
+struct MovePicker {
+  const Board& b;
+  const SearchState& st;
+  Move ttMove, killer1, killer2;
+  bool capturesOnly;
+  int stage;
+  int cur = 0;
+  MoveList list;
+  MoveList bad;   // capturas con SEE < 0, se prueban al final
+
+  // búsqueda principal
+  MovePicker(const Board& board, const SearchState& s, int ply, Move tt, bool inCheck)
+    : b(board), st(s), ttMove(tt), killer1(s.killers[ply][0]), killer2(s.killers[ply][1]),
+      capturesOnly(false), stage(inCheck ? STAGE_EVASION_TT : STAGE_TT) {}
+
+  // quiescence: solo capturas/promociones con SEE >= 0 (las malas se descartan);
+  // en jaque, todas las evasiones
+  MovePicker(const Board& board, const SearchState& s, bool inCheck)
+    : b(board), st(s), ttMove(Move::none()), killer1(Move::none()), killer2(Move::none()),
+      capturesOnly(true), stage(inCheck ? STAGE_GEN_EVASIONS : STAGE_GEN_CAPTURES) {}
+
+  // Mover al frente la de mayor score en [cur, count)
+  Move pick_best() {
+    int best = cur;
+    for (int i = cur + 1; i < list.count; i++)
+      if (list.scores[i] > list.scores[best]) best = i;
+    swap(list.moves[cur], list.moves[best]);
+    swap(list.scores[cur], list.scores[best]);
+    return list.moves[cur++];
+  }
+
+  bool is_special(Move m) const {
+    return m == ttMove || m == killer1 || m == killer2;
+  }
+
+  Move next() {
+    switch (stage) {
+      case STAGE_TT:
+        stage = STAGE_GEN_CAPTURES;
+        if (b.is_legal(ttMove)) return ttMove;
+        ttMove = Move::none();
+        [[fallthrough]];
+
+      case STAGE_GEN_CAPTURES:
+        list.clear();
+        b.generate(list, GEN_CAPTURES);
+        for (int i = 0; i < list.count; i++) {
+          Move m = list[i];
+          list.scores[i] = mvv_lva(b, m) + (m.promo() != EMPTY ? PV[m.promo()] * 10 : 0);
+        }
+        cur = 0;
+        bad.clear();
+        stage = STAGE_GOOD_CAPTURES;
+        [[fallthrough]];
+
+      case STAGE_GOOD_CAPTURES:
+        while (cur < list.count) {
+          Move m = pick_best();
+          if (m == ttMove) continue;
+          if (!b.see_ge(m)) {
+            if (!capturesOnly) bad.push(m);
+            continue;
+          }
+          return m;
+        }
+        if (capturesOnly) { stage = STAGE_DONE; return Move::none(); }
+        stage = STAGE_KILLER1;
+        [[fallthrough]];
+
+      case STAGE_KILLER1:
+        stage = STAGE_KILLER2;
+        if (killer1 != ttMove && !killer1.is_capture() && b.is_legal(killer1)) return killer1;
+        [[fallthrough]];
+
+      case STAGE_KILLER2:
+        stage = STAGE_GEN_QUIETS;
+        if (killer2 != ttMove && killer2 != killer1 && !killer2.is_capture() && b.is_legal(killer2))
+          return killer2;
+        [[fallthrough]];
+
+      case STAGE_GEN_QUIETS:
+        // reusar la lista: las capturas ya se consumieron
+        list.clear();
+        b.generate(list, GEN_QUIETS);
+        for (int i = 0; i < list.count; i++)
+          list.scores[i] = st.history[b.side][list[i].from()][list[i].to()];
+        cur = 0;
+        stage = STAGE_QUIETS;
+        [[fallthrough]];
+
+      case STAGE_QUIETS:
+        while (cur < list.count) {
+          Move m = pick_best();
+          if (!is_special(m)) return m;
+        }
+        cur = 0;
+        stage = STAGE_BAD_CAPTURES;
+        [[fallthrough]];
+
+      case STAGE_BAD_CAPTURES:
+        // ya ordenadas por MVV-LVA al descartarlas
+        if (cur < bad.count) return bad[cur++];
+        stage = STAGE_DONE;
+        return Move::none();
+
+      case STAGE_EVASION_TT:
+        stage = STAGE_GEN_EVASIONS;
+        if (b.is_legal(ttMove)) return ttMove;
+        ttMove = Move::none();
+        [[fallthrough]];
+
+      case STAGE_GEN_EVASIONS:
+        list.clear();
+        b.generate(list, GEN_EVASIONS);
+        for (int i = 0; i < list.count; i++) {
+          Move m = list[i];
+          if (m.is_capture() || m.promo() != EMPTY)
+            list.scores[i] = EVASION_CAPTURE_SCORE + mvv_lva(b, m) + (m.promo() != EMPTY ? PV[m.promo()] * 10 : 0);
+          else
+            list.scores[i] = st.history[b.side][m.from()][m.to()];
+        }
+        cur = 0;
+        stage = STAGE_EVASIONS;
+        [[fallthrough]];
+
+      case STAGE_EVASIONS:
+        while (cur < list.count) {
+          Move m = pick_best();
+          if (m != ttMove) return m;
+        }
+        stage = STAGE_DONE;
+        [[fallthrough]];
+
+      default:
+        return Move::none();
+    }
+  }
+};
+
+// Con stop levantado las funciones devuelven 0 sin tocar TT/killers/history:
+// el llamador descarta ese valor y la iteración abortada entera.
+static int qsearch(Board& b, int alpha, int beta, SearchState& st, int ply) {
+  if (st.time_up()) return 0;
+  st.add_node();
+  STAT(st, qnodes);
+  if (ply > st.seldepth) st.seldepth = ply;
+  if (ply >= MAX_PLY - 1) return eval(b, st.pawns);
+
+  // en jaque no hay stand pat: hay que salir del jaque (o es mate)
+  bool inCheck = b.in_check(b.side);
+  int stand = -INF;
+  if (!inCheck) {
+    stand = eval(b, st.pawns);
+    if (stand >= beta) return beta;
+    if (stand > alpha) alpha = stand;
+  }
+
+  // Capturas y promociones, por etapas (SEE < 0 ya podadas por el picker)
+  MovePicker mp(b, st, inCheck);
+  int legalMoves = 0;
+  for (Move m = mp.next(); !m.is_null(); m = mp.next()) {
+    legalMoves++;
+    // delta pruning: ni ganando la pieza capturada (más margen) se llega a alpha
+    if (!inCheck && m.promo() == EMPTY) {
+      int gain = m.is_enpassant() ? PV[PAWN] : PV[abs_piece(b.sq[m.to()])];
+      if (stand + gain + DELTA_MARGIN <= alpha) continue;
+    }
+
+    Undo u;
+    b.make_move(m, u);
+    int score = -qsearch(b, -beta, -alpha, st, ply + 1);
+    b.unmake_move(m, u);
+    if (st.time_up()) return 0;
+
+    if (score >= beta) return beta;
+    if (score > alpha) alpha = score;
+  }
+  if (inCheck && legalMoves == 0) return -MATE + ply;
+  return alpha;
+}
+
+// PVS + null move + LMR + reverse futility/razoring + extensión por jaque.
+// nullOk=false en el hijo de un null move (no encadenar dos seguidos).
+static int negamax(Board& b, int depth, int alpha, int beta, SearchState& st, int ply, Move& outBest,
+                   bool nullOk = true) {
+  if (st.time_up()) return 0;
+  st.add_node();
+
+  if (ply > st.seldepth) st.seldepth = ply;
+  st.pv_len[ply] = ply;
+
+  if (b.halfmove >= 100) return 0;         // 50-move draw
+  if (b.is_repetition()) return 0;
+  if (ply >= MAX_PLY - 1) return eval(b, st.pawns);
+
+  bool inCheck = b.in_check(b.side);
+  bool pvNode = beta - alpha > 1;
+
+  // extensión por jaque: no entrar a qsearch estando en jaque
+  if (inCheck) depth++;
+
+  if (depth <= 0) return qsearch(b, alpha, beta, st, ply);
+
+  // TT probe
+  Move ttBest = Move::none();
+  TTHit tte;
+  STAT(st, tt_probes);
+  if (st.tt->probe(b.key, tte)) {
+    STAT(st, tt_hits);
+    ttBest = tte.best;
+    // en la raíz no cortar: hace falta outBest (la TT puede venir de otro thread o búsqueda);
+    // en nodos PV tampoco: el corte no arma pv[ply] y el info saldría con una sola jugada
+    if (!pvNode && ply > 0 && tte.depth >= depth) {
+      int ttScore = score_from_tt(tte.score, ply);
+      if (tte.flag == TT_EXACT
+          || (tte.flag == TT_ALPHA && ttScore <= alpha)
+          || (tte.flag == TT_BETA  && ttScore >= beta)) {
+        STAT(st, tt_cuts);
+        return ttScore;
+      }
+    }
+  }
+
+  // Syzygy WDL: resultado exacto, no hace falta buscar
+  if (st.tb_pieces && ply > 0 && popcnt(b.occupied()) <= st.tb_pieces) {
+    int tbScore;
+    if (syzygy_probe_wdl(b, ply, tbScore)) {
+      st.tb_hits.fetch_add(1, memory_order_relaxed);
+      st.tt->store(b.key, min(depth + 6, MAX_PLY - 1), TT_EXACT, tbScore, Move::none());
+      return tbScore;
+    }
+  }
+
+  if (!pvNode && !inCheck && ply > 0) {
+    int staticEval = eval(b, st.pawns);
+
+    // reverse futility: muy por encima de beta a poca profundidad
+    if (depth <= RFP_MAX_DEPTH && !is_mate_score(beta) && staticEval - RFP_MARGIN * depth >= beta)
+      return staticEval;
+
+    // razoring: muy por debajo de alpha, confirmar con qsearch
+    if (depth <= RAZOR_MAX_DEPTH && staticEval + RAZOR_MARGIN * depth < alpha) {
+      int v = qsearch(b, alpha - 1, alpha, st, ply);
+      if (st.time_up()) return 0;
+      if (v < alpha) return v;
+    }
+
+    // null move (sin zugzwang obvio: queda alguna pieza)
+    if (nullOk && depth >= NULL_MIN_DEPTH && staticEval >= beta && b.has_non_pawn_material(b.side)) {
+      int R = 3 + depth / 6;
+      Undo nu;
+      b.make_null(nu);
+      Move nullBest = Move::none();
+      int v = -negamax(b, depth - 1 - R, -beta, -beta + 1, st, ply + 1, nullBest, false);
+      b.unmake_null(nu);
+      if (st.time_up()) return 0;
+      if (v >= beta) return is_mate_score(v) ? beta : v;
+    }
+  }
+
+  int bestScore = -INF;
+  Move bestMove = Move::none();
+
+  int origAlpha = alpha;
+  int legalMoves = 0;
+
+  MovePicker mp(b, st, ply, ttBest, inCheck);
+  for (Move m = mp.next(); !m.is_null(); m = mp.next()) {
+    if (ply == 0 && !st.excluded.empty() && st.excluded.contains(m)) continue;
+    legalMoves++;
+
+    bool quiet = !m.is_capture() && m.promo() == EMPTY;
+    int hist = quiet ? st.history[b.side][m.from()][m.to()] : 0;
+
+    Undo u;
+    b.make_move(m, u);
+    st.tt->prefetch(b.key);
+
+    bool givesCheck = b.in_check(b.side);
+    int newDepth = depth - 1;
+    Move childBest = Move::none();
+    int score;
+
+    if (legalMoves == 1) {
+      score = -negamax(b, newDepth, -beta, -alpha, st, ply + 1, childBest);
+    } else {
+      // LMR: quietas tardías, menos reducción si la history es buena
+      int r = 0;
+      if (depth >= 3 && legalMoves > 3 && quiet && !inCheck && !givesCheck) {
+        r = LMR_TABLE[min(depth, 63)][min(legalMoves, 63)];
+        if (pvNode) r--;
+        r -= min(2, hist / HISTORY_LMR_DIV);
+        r = clamp(r, 0, newDepth - 1);
+      }
+
+      // PVS: ventana nula, re-search si mejora alpha
+      score = -negamax(b, newDepth - r, -alpha - 1, -alpha, st, ply + 1, childBest);
+      if (score > alpha && r > 0)
+        score = -negamax(b, newDepth, -alpha - 1, -alpha, st, ply + 1, childBest);
+      if (score > alpha && score < beta)
+        score = -negamax(b, newDepth, -beta, -alpha, st, ply + 1, childBest);
+    }
+
+    b.unmake_move(m, u);
+    if (st.time_up()) return 0;
+
+    if (score > bestScore) {
+      bestScore = score;
+      bestMove = m;
+    }
+    if (score > alpha) {
+      alpha = score;
+      if (pvNode) st.update_pv(ply, m);
+    }
+    if (alpha >= beta) {
+      STAT(st, fail_high);
+      if (legalMoves == 1) STAT(st, fail_high_first);
+      // beta cutoff: update killers/history for quiet moves
+      if (quiet) {
+        if (st.killers[ply][0] != m) {
+          st.killers[ply][1] = st.killers[ply][0];
+          st.killers[ply][0] = m;
+        }
+        st.history[b.side][m.from()][m.to()] += depth * depth;
+      }
+      break;
+    }
+  }
+
+  if (legalMoves == 0) {
+    if (inCheck) return -MATE + ply;
+    return 0; // stalemate
+  }
+
+  outBest = bestMove;
+
+  // Store TT (no en la raíz con jugadas excluidas: no es el valor real de la posición)
+  if (ply == 0 && !st.excluded.empty()) return bestScore;
+  TTFlag flag = TT_EXACT;
+  if (bestScore <= origAlpha) flag = TT_ALPHA;
+  else if (bestScore >= beta) flag = TT_BETA;
+  st.tt->store(b.key, depth, flag, score_to_tt(bestScore, ply), bestMove);
+
+  return bestScore;
+}
+
+
+// ---------------- Lazy SMP ----------------
+
+// Escalonamiento de profundidad de los helpers (thread i usa la fila (i-1) % 20):
+// cada helper saltea algunas iteraciones para que no todos busquen el mismo depth.
+static constexpr int SKIP_SIZE[20]  = {1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4};
+static constexpr int SKIP_PHASE[20] = {0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7};
+
+using SearchStates = vector<unique_ptr<SearchState>>;
+
+static uint64_t total_nodes(const SearchStates& states) {
+  uint64_t n = 0;
+  for (const auto& st : states) n += st->nodes.load(memory_order_relaxed);
+  return n;
+}
+
+static uint64_t total_tb_hits(const SearchStates& states) {
+  uint64_t n = 0;
+  for (const auto& st : states) n += st->tb_hits.load(memory_order_relaxed);
+  return n;
+}
+
+// "cp X" o "mate N" (N en jugadas, negativo si nos dan mate)
+string score_to_uci(int s) {
+  if (is_mate_score(s)) return "mate " + to_string(mate_in_moves(s));
+  return "cp " + to_string(s);
+}
+
+struct RootLine {
+  int score = 0;
+  vector<Move> pv;
+};
+
+// Nivel < MAX_SKILL: entre las líneas (ordenadas por score) gana la de mayor
+// score + ruido; el ruido crece con la debilidad y con la distancia a la mejor.
+static const RootLine& skill_pick(const vector<RootLine>& lines, int level) {
+  static thread_local mt19937 rng(random_device{}());
+  const int top = lines[0].score;
+  const int delta = min(top - lines.back().score, PV[PAWN]);
+  const int weakness = 120 - 2 * level;
+  const RootLine* best = &lines[0];
+  int bestValue = -INF;
+  for (const auto& line : lines) {
+    int push = (weakness * (top - line.score) + delta * (int)(rng() % weakness)) / 128;
+    if (line.score + push >= bestValue) {
+      bestValue = line.score + push;
+      best = &line;
+    }
+  }
+  return *best;
+}
+
+// Iterative deepening con aspiration windows. Lo corren el thread principal
+// (imprime info y define el resultado) y cada helper sobre su propia copia del Board.
+// MultiPV (solo el principal): por depth, K búsquedas de raíz excluyendo las
+// jugadas de las líneas ya encontradas.
+static Move iterative_deepening(Board& b, SearchState& st, int maxDepth, int& outScoreCp,
+                                const SearchStates& all, chrono::steady_clock::time_point start) {
+  Move best = Move::none();
+  int bestScore = -INF;
+
+  const int WINDOW = 80;      // centipawns (50-80 suele ir bien)
+
+  MoveList root;
+  b.gen_legal(root);
+  if (root.empty()) {
+    outScoreCp = 0;
+    return Move::none(); // terminal real
+  }
+
+  // fallback: siempre una jugada legal
+  best = root[0];
+  bestScore = 0;
+
+  const SearchControl* ctl = st.ctl;
+  const bool skillOn = st.id == 0 && ctl && ctl->skill < MAX_SKILL;
+  const int wantPV = ctl ? max(ctl->multipv, skillOn ? SKILL_MULTI_PV : 1) : 1;
+  const int multiPV = (st.id == 0 && ctl) ? clamp(wantPV, 1, root.size()) : 1;
+  vector<RootLine> lines;                  // último depth, ordenadas por score
+  vector<int> prevScores(multiPV, 0);      // score por línea del depth anterior, para aspiration
+
+  // time manager (solo el principal): iteraciones con la misma mejor jugada
+  int stableIters = 0;
+  int prevIterScore = 0;
+  Move lastBest = Move::none();
+
+  auto iterStart = start;
+
+  for (int depth = 1; depth <= maxDepth; depth++) {
+    if (st.time_up()) break;
+
+    if (st.id > 0 && depth > 1) {
+      int row = (st.id - 1) % 20;
+      if (((depth + SKIP_PHASE[row]) / SKIP_SIZE[row]) % 2) continue;
+    }
+
+    if (st.id == 0) iterStart = chrono::steady_clock::now();
+    st.seldepth = 0;   // "seldepth" del info es el de esta iteración
+    vector<RootLine> iter;
+    bool partial = false;                  // se cortó antes de terminar las multiPV líneas
+    st.excluded.clear();
+
+    for (int pvIdx = 0; pvIdx < multiPV; pvIdx++) {
+      int alpha = -INF, beta = INF;
+      if (depth >= 2) {
+        alpha = prevScores[pvIdx] - WINDOW;
+        beta  = prevScores[pvIdx] + WINDOW;
+      }
+      // fallback: si corta por tiempo, no perdés PV
+      Move fallback = (pvIdx < (int)lines.size()) ? lines[pvIdx].pv[0] : best;
+      if (st.excluded.contains(fallback)) fallback = Move::none();
+      Move pv = fallback;
+      int score = negamax(b, depth, alpha, beta, st, 0, pv);
+
+      // si falla la ventana y aún hay tiempo, re-search con ventana completa
+      if (!st.time_up() && depth >= 2) {
+        if (score <= alpha || score >= beta) {
+          STAT(st, asp_researches);
+          pv = fallback;          // mismo motivo: no borres el PV
+          score = negamax(b, depth, -INF, INF, st, 0, pv);
+        }
+      }
+
+      if (st.time_up()) { partial = true; break; }
+      if (pv.is_null() || st.excluded.contains(pv)) break;   // raíz sin jugadas nuevas (tablas por regla)
+
+      RootLine line;
+      line.score = score;
+      if (st.pv_len[0] > 0 && st.pv[0][0] == pv)
+        line.pv.assign(st.pv[0].begin(), st.pv[0].begin() + st.pv_len[0]);
+      else
+        line.pv.push_back(pv);
+      st.excluded.push(pv);
+      iter.push_back(move(line));
+    }
+
+    if (iter.empty()) break;
+    stable_sort(iter.begin(), iter.end(), [](const RootLine& x, const RootLine& y) { return x.score > y.score; });
+    // depth incompleto: las líneas nuevas son las mejores (se buscan en orden);
+    // el resto sale del depth anterior, así no se pierden candidatas (skill_pick)
+    if (partial) {
+      for (auto& old : lines) {
+        if ((int)iter.size() >= multiPV) break;
+        bool dup = any_of(iter.begin(), iter.end(), [&](const RootLine& l) { return l.pv[0] == old.pv[0]; });
+        if (!dup) iter.push_back(move(old));
+      }
+    }
+    for (size_t i = 0; i < iter.size(); i++) prevScores[i] = iter[i].score;
+    lines = move(iter);
+
+    best = lines[0].pv[0];
+    bestScore = lines[0].score;
+
+    // MultiPV cortado a mitad de un depth: las líneas completas valen, no se imprime
+    if (st.time_up()) break;
+    st.completed_depth = depth;
+
+    if (st.id != 0) continue;
+
+    // Soft limit: ajustar el objetivo por estabilidad de la jugada y caída del score
+    bool flipped = depth > 1 && best != lastBest;
+    int drop = (depth > 1) ? prevIterScore - bestScore : 0;
+    stableIters = flipped ? 0 : stableIters + 1;
+    lastBest = best;
+    prevIterScore = bestScore;
+    bool softStop = false;
+
+    int soft = ctl ? ctl->soft_ms.load(memory_order_relaxed) : 0;
+    if (soft > 0 && !ctl->ponder.load(memory_order_relaxed)) {
+      double scale = 1.0;
+      if (stableIters >= 6) scale = 0.4;
+      else if (stableIters >= 3) scale = 0.7;
+      else if (flipped) scale = 1.6;
+      if (drop > 60) scale *= 1.6;
+      else if (drop > 25) scale *= 1.25;
+
+      // la próxima iteración cuesta ~ lo mismo que todas las anteriores:
+      // no arrancarla si pasado la mitad del objetivo
+      int64_t elapsed = ctl->elapsed_ms();
+      softStop = root.size() == 1 || elapsed * 2 >= (int64_t)(soft * scale);
+    }
+
+    // NPS real (tiempo transcurrido), sumando todos los threads
+    auto now = chrono::steady_clock::now();
+    double sec = chrono::duration<double>(now - start).count();
+    uint64_t nodes = total_nodes(all);
+    int nps = (sec > 0.0) ? (int)(nodes / sec) : 0;
+
+    outScoreCp = bestScore;
+    if (ctl && !ctl->quiet) {
+      // la última línea del depth se vuelca ya: en go infinite / ponder o con
+      // iteraciones largas no puede quedar en el buffer hasta el próximo depth
+      const bool stats = SEARCH_STATS_ENABLED && ctl->debug.load(memory_order_relaxed);
+      for (size_t i = 0; i < lines.size(); i++) {
+        ostringstream info;
+        info << "info depth " << depth
+             << " seldepth " << st.seldepth
+             << " multipv " << (i + 1)
+             << " score " << score_to_uci(lines[i].score)
+             << " nodes " << nodes
+             << " nps " << nps
+             << " hashfull " << st.tt->hashfull()
+             << " time " << (int64_t)(sec * 1000.0);
+        if (st.tb_pieces) info << " tbhits " << total_tb_hits(all);
+        info << " pv";
+        for (Move m : lines[i].pv) info << ' ' << move_to_uci(m);
+        ctl->send(info.str(), !stats && i + 1 == lines.size());
+      }
+
+      // stats del thread principal (los helpers se suman al final de la búsqueda)
+      if (stats) {
+        auto iterMs = chrono::duration_cast<chrono::milliseconds>(now - iterStart).count();
+        ctl->send("info string stats depth " + to_string(depth) + " itertime " + to_string(iterMs) +
+                  " " + format_stats(st.stats, st.nodes.load(memory_order_relaxed)));
+      }
+    }
+
+    if (softStop) break;
+  }
+
+  if (skillOn && lines.size() > 1) {
+    const RootLine& pick = skill_pick(lines, ctl->skill);
+    best = pick.pv[0];
+    bestScore = pick.score;
+  }
+
+  outScoreCp = bestScore;
+  return best;
+}
+
+// Los límites de tiempo / stop vienen en 'ctl' (el llamador fija deadline o ponder).
+Move search_bestmove(Board& b, const SearchControl& ctl, int maxDepth, int& outScoreCp,
+                     uint64_t* outNodes, int* outDepth) {
+  auto start = chrono::steady_clock::now();
+  atomic<bool> stop_all{false};
+  atomic<uint64_t> shared_nodes{0};
+  if (NNUE_ON) b.nnue_refresh();   // la red pudo activarse con el tablero ya armado
+
+  // Final en tabla: la jugada sale de la DTZ, sin buscar
+  Move tbMove;
+  if (syzygy_largest() && ctl.multipv == 1 && ctl.skill >= MAX_SKILL && syzygy_root_move(b, tbMove, outScoreCp)) {
+    if (!ctl.quiet)
+      ctl.send("info depth 1 seldepth 1 multipv 1 score cp " + to_string(outScoreCp) +
+               " nodes 0 nps 0 tbhits 1 time 0 pv " + move_to_uci(tbMove));
+    if (outNodes) *outNodes = 0;
+    if (outDepth) *outDepth = 0;
+    return tbMove;
+  }
+  const int tbPieces = min(SYZYGY_PROBE_LIMIT, syzygy_largest());
+  TranspositionTable& tt = ctl.tt ? *ctl.tt : TT;
+  tt.new_search();
+
+  // nivel limitado: un solo thread (el presupuesto es de nodos, más threads no suman)
+  const int nthreads = (!HAS_THREADS || ctl.skill < MAX_SKILL) ? 1 : max(1, ctl.threads > 0 ? ctl.threads : SEARCH_THREADS);
+  SearchStates states;
+  for (int i = 0; i < nthreads; i++) {
+    auto st = make_unique<SearchState>();
+    st->id = i;
+    st->ctl = &ctl;
+    st->stop_flag = &stop_all;
+    st->shared_nodes = &shared_nodes;
+    st->tt = &tt;
+    st->tb_pieces = tbPieces;
+    states.push_back(move(st));
+  }
+
+  // Helpers: comparten solo la TT (lock-free) y el flag de stop
+  vector<thread> helpers;
+  for (int i = 1; i < nthreads; i++) {
+    helpers.emplace_back([&, i]() {
+      Board hb = b;
+      int ignored = 0;
+      iterative_deepening(hb, *states[i], maxDepth, ignored, states, start);
+    });
+  }
+
+  Move best = iterative_deepening(b, *states[0], maxDepth, outScoreCp, states, start);
+
+  stop_all.store(true, memory_order_relaxed);
+  for (auto& t : helpers) t.join();
+  uint64_t nodes = total_nodes(states);
+  if (outNodes) *outNodes = nodes;
+  if (outDepth) *outDepth = states[0]->completed_depth;
+
+  if (SEARCH_STATS_ENABLED && !ctl.quiet && ctl.debug.load(memory_order_relaxed)) {
+    SearchStats sum;
+    for (const auto& st : states) sum.add(st->stats);
+    ctl.send("info string stats total threads " + to_string(nthreads) + " nodes " + to_string(nodes) +
+             " " + format_stats(sum, nodes), false);
+  }
+  return best;
+}
+
+
+// ---------------- Bench ----------------
+const vector<string> BENCH_FENS = {
+  "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+  "r1bqkb1r/pppp1ppp/2n2n2/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4",
+  "r1b1kb1r/pp3ppp/2n1pn2/q1pp4/2PP4/2N1PN2/PP1B1PPP/R2QKB1R w KQkq - 0 1",
+  "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 10",
+  "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+  "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+  "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+  "4rrk1/pp1n3p/3q2pQ/2p1pb2/2PP4/2P3N1/P2B2PP/4RRK1 b - - 7 19",
+  "rq3rk1/ppp2ppp/1bnpb3/3N2B1/3NP3/7P/PPPQ1PP1/2KR3R w - - 7 14",
+  "r1bq1r1k/1pp1n1pp/1p1p4/4p2Q/4Pp2/1BNP4/PPP2PPP/3R1RK1 w - - 2 14",
+  "r3r1k1/2p2ppp/p1p1bn2/8/1q2P3/2NPQN2/PPP3PP/R4RK1 b - - 2 15",
+  "r1bbk1nr/pp3p1p/2n5/1N4p1/2Np1B2/8/PPP2PPP/2KR1B1R w kq - 0 13",
+  "r1bq1rk1/ppp1nppp/4n3/3p3Q/3P4/1BP1B3/PP1N2PP/R4RK1 w - - 1 16",
+  "4r1k1/r1q2ppp/ppp2n2/4P3/5Rb1/1N1BQ3/PPP3PP/R5K1 w - - 1 17",
+  "2rqkb1r/ppp2p2/2npb1p1/1N1Nn2p/2P1PP2/8/PP2B1PP/R1BQK2R b KQ - 0 11",
+  "r1bq1r1k/b1p1npp1/p2p3p/1p6/3PP3/1B2NN2/PP3PPP/R2Q1RK1 w - - 1 16",
+  "3r1rk1/p5pp/bpp1pp2/8/q1PP1P2/b3P3/P2NQRPP/1R2B1K1 b - - 6 22",
+  "r1q2rk1/2p1bppp/2Pp4/p6b/Q1PNp3/4B3/PP1R1PPP/2K4R w - - 2 18",
+  "4k2r/1pb2ppp/1p2p3/1R1p4/3P4/2r1PN2/P4PPP/1R4K1 b - - 3 22",
+  "3q2k1/pb3p1p/4pbp1/2r5/PpN2N2/1P2P2P/5PP1/Q2R2K1 b - - 4 26",
+  "r3k2r/3nnpbp/q2pp1p1/p7/Pp1PPPP1/4BNN1/1P5P/R2Q1RK1 w kq - 0 16",
+  "3Qb1k1/1r2ppb1/pN1n2q1/Pp1Pp1Pr/4P2p/4BP2/4B1R1/1R5K b - - 11 40",
+  "4k3/3q1r2/1N2r1b1/3ppN2/2nPP3/1B1R2n1/2R1Q3/3K4 w - - 5 1",
+  "4rrk1/1p1nq3/p7/2p1P1pp/3P2bp/3Q1Bn1/PPPB4/1K2R1NR w - - 40 21",
+  "5rk1/q6p/2p3bR/1pPp1rP1/1P1Pp3/P3B1Q1/1K3P2/R7 w - - 93 90",
+  "6k1/3b3r/1p1p4/p1n2p2/1PPNpP1q/P3Q1p1/1R1RB1P1/5K2 b - - 0 1",
+  "r2r1n2/pp2bk2/2p1p2p/3q4/3PN1QP/2P3R1/P4PP1/5RK1 w - - 0 1",
+  "6k1/6p1/6Pp/ppp5/3pn2P/1P3K2/1PP2P2/3N4 b - - 0 1",
+  "3b4/5kp1/1p1p1p1p/pP1PpP1P/P1P1P3/3KN3/8/8 w - - 0 1",
+  "2K5/p7/7P/5pR1/8/5k2/r7/8 w - - 0 1",
+  "8/6pk/1p6/8/PP3p1p/5P2/4KP1q/3Q4 w - - 0 1",
+  "7k/3p2pp/4q3/8/4Q3/5Kp1/P6b/8 w - - 0 1",
+  "8/2p5/8/2kPKp1p/2p4P/2P5/3P4/8 w - - 0 1",
+  "8/1p3pp1/7p/5P1P/2k3P1/8/2K2P2/8 w - - 0 1",
+  "8/pp2r1k1/2p1p3/3pP2p/1P1P1P1P/P5KR/8/8 w - - 0 1",
+  "8/3p4/p1bk3p/Pp6/1Kp1PpPp/2P2P1P/2P5/5B2 b - - 0 1",
+  "5k2/7R/4P2p/5K2/p1r2P1p/8/8/8 b - - 0 1",
+  "6k1/6p1/P6p/r1N5/5p2/7P/1b3PP1/4R1K1 w - - 0 1",
+  "1r3k2/4q3/2Pp3b/3Bp3/2Q2p2/1p1P2P1/1P2KP2/3N4 w - - 0 1",
+  "6k1/4pp1p/3p2p1/P1pPb3/R7/1r2P1PP/3B1P2/6K1 w - - 0 1",
+  "8/3p3B/5p2/5P2/p7/PP5b/k7/6K1 w - - 0 1",
+  "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 11",
+  "8/8/8/8/5kp1/P7/8/1K1N4 w - - 0 1",
+  "8/8/8/5N2/8/p7/8/2NK3k w - - 0 1",
+  "8/3k4/8/8/8/4B3/4KB2/2B5 w - - 0 1",
+  "8/8/1P6/5pr1/8/4R3/7k/2K5 w - - 0 1",
+  "8/2p4P/8/kr6/6R1/8/8/1K6 w - - 0 1",
+  "8/8/3P3k/8/1p6/8/1P6/1K3n2 b - - 0 1",
+  "8/R7/2q5/8/6k1/8/1P5p/K6R w - - 0 124",
+  "1K1k4/1P6/8/8/8/8/r7/2R5 w - - 0 1",
+};
+
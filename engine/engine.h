@@ -0,0 +1,1429 @@
+// Núcleo del engine (bm_core): tablero, generación, eval, TT y búsqueda.
+// Lo comparten bm_engine (UCI/CLI) y bm_microbench.
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <array>
+#include <sstream>
+#include <cctype>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <bit>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
+#if defined(USE_PEXT)
+#include <immintrin.h>
+#endif
+
+#include "nnue.h"
+
+using namespace std;
+
+// WASM sin pthreads: sin std::thread, "go" busca en el mismo thread que lo recibe
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+inline constexpr bool HAS_THREADS = false;
+#else
+inline constexpr bool HAS_THREADS = true;
+#endif
+
+enum Color : int { WHITE = 0, BLACK = 1 };
+
+enum PieceType : int {
+  EMPTY = 0,
+  PAWN = 1,
+  KNIGHT = 2,
+  BISHOP = 3,
+  ROOK = 4,
+  QUEEN = 5,
+  KING = 6
+};
+
+// piece encoding: 0 empty, +1..+6 white, -1..-6 black
+constexpr Color color_of(int8_t p) { return p > 0 ? WHITE : BLACK; }
+constexpr int abs_piece(int8_t p) { return p >= 0 ? p : -p; }
+
+constexpr int file_of(int sq) { return sq & 7; }
+constexpr int rank_of(int sq) { return sq >> 3; }
+inline bool on_board(int f, int r) { return f >= 0 && f < 8 && r >= 0 && r < 8; }
+inline int sq_of(int f, int r) { return r * 8 + f; }
+
+inline string sq_to_str(int sq) {
+  string s = "a1";
+  s[0] = char('a' + file_of(sq));
+  s[1] = char('1' + rank_of(sq));
+  return s;
+}
+inline int str_to_sq(const string& s) {
+  if (s.size() != 2) return -1;
+  int f = s[0] - 'a';
+  int r = s[1] - '1';
+  if (!on_board(f, r)) return -1;
+  return sq_of(f, r);
+}
+
+inline char promo_to_char(int promo) {
+  switch (promo) {
+    case QUEEN: return 'q';
+    case ROOK:  return 'r';
+    case BISHOP:return 'b';
+    case KNIGHT:return 'n';
+    default:    return '\0';
+  }
+}
+inline int char_to_promo(char c) {
+  c = (char)tolower((unsigned char)c);
+  if (c == 'q') return QUEEN;
+  if (c == 'r') return ROOK;
+  if (c == 'b') return BISHOP;
+  if (c == 'n') return KNIGHT;
+  return EMPTY;
+}
+
+inline const string START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+// ---------------- Bitboards ----------------
+using Bitboard = uint64_t;
+
+inline constexpr Bitboard FILE_A_BB = 0x0101010101010101ULL;
+inline constexpr Bitboard FILE_H_BB = FILE_A_BB << 7;
+inline constexpr Bitboard RANK_1_BB = 0xFFULL;
+inline constexpr Bitboard RANK_8_BB = RANK_1_BB << 56;
+
+constexpr Bitboard bb_sq(int sq) { return 1ULL << sq; }
+constexpr Bitboard file_bb(int f) { return FILE_A_BB << f; }
+inline Bitboard rank_bb(int r) { return RANK_1_BB << (8 * r); }
+inline int lsb(Bitboard b) { return countr_zero(b); }
+inline int pop_lsb(Bitboard& b) { int s = countr_zero(b); b &= b - 1; return s; }
+inline int popcnt(Bitboard b) { return popcount(b); }
+
+// Precomputed leaper attacks
+inline array<Bitboard, 64> KNIGHT_ATT;
+inline array<Bitboard, 64> KING_ATT;
+inline array<array<Bitboard, 64>, 2> PAWN_ATT; // [color][sq] casillas atacadas por un peón en sq
+
+// Slider attacks: magic bitboards (o PEXT si se compila con BM_USE_PEXT)
+struct Magic {
+  Bitboard mask = 0;
+  Bitboard magic = 0;
+  Bitboard* attacks = nullptr;
+  int shift = 0;
+
+  unsigned index(Bitboard occ) const {
+#if defined(USE_PEXT)
+    return (unsigned)_pext_u64(occ, mask);
+#else
+    return (unsigned)(((occ & mask) * magic) >> shift);
+#endif
+  }
+};
+
+// Casillas estrictamente entre a y b / línea completa a-b (0 si no están alineadas)
+inline array<array<Bitboard, 64>, 64> BETWEEN_BB;
+inline array<array<Bitboard, 64>, 64> LINE_BB;
+
+inline array<Magic, 64> ROOK_MAGICS;
+inline array<Magic, 64> BISHOP_MAGICS;
+inline array<Bitboard, 0x19000> ROOK_TABLE;  // suma de 2^bits sobre las 64 casillas
+inline array<Bitboard, 0x1480> BISHOP_TABLE;
+
+inline Bitboard rook_attacks(int sq, Bitboard occ) {
+  const Magic& m = ROOK_MAGICS[sq];
+  return m.attacks[m.index(occ)];
+}
+inline Bitboard bishop_attacks(int sq, Bitboard occ) {
+  const Magic& m = BISHOP_MAGICS[sq];
+  return m.attacks[m.index(occ)];
+}
+inline Bitboard queen_attacks(int sq, Bitboard occ) {
+  return rook_attacks(sq, occ) | bishop_attacks(sq, occ);
+}
+inline Bitboard piece_attacks(int pt, int sq, Bitboard occ) {
+  switch (pt) {
+    case KNIGHT: return KNIGHT_ATT[sq];
+    case BISHOP: return bishop_attacks(sq, occ);
+    case ROOK:   return rook_attacks(sq, occ);
+    case QUEEN:  return queen_attacks(sq, occ);
+    default:     return KING_ATT[sq];
+  }
+}
+template <int Pt>
+inline Bitboard piece_attacks(int sq, Bitboard occ) {
+  if constexpr (Pt == KNIGHT) return KNIGHT_ATT[sq];
+  else if constexpr (Pt == BISHOP) return bishop_attacks(sq, occ);
+  else if constexpr (Pt == ROOK) return rook_attacks(sq, occ);
+  else if constexpr (Pt == QUEEN) return queen_attacks(sq, occ);
+  else return KING_ATT[sq];
+}
+
+void init_attack_tables();
+
+// ---------------- Zobrist ----------------
+inline array<array<uint64_t, 64>, 12> Z_PIECE; // 12 piece kinds
+inline array<uint64_t, 16> Z_CASTLE;
+inline array<uint64_t, 8>  Z_EPFILE;
+inline uint64_t Z_SIDE;
+
+inline int pidx(int8_t p) {
+  int ap = abs_piece(p);
+  if (p > 0) return ap - 1;          // 0..5
+  return 6 + (ap - 1);              // 6..11
+}
+
+void init_zobrist(uint64_t seed = 0xC0FFEEULL);
+
+// ---------------- Move ----------------
+// 16 bits: from (6) | to (6) | flags (4). Flags: bit2 = captura, bit3 = promoción
+// (bits 0-1 = pieza N/B/R/Q); sin promoción: 0 quieta, 1 doble avance, 2 enroque, 5 al paso.
+struct Move {
+  uint16_t data;
+
+  static constexpr int QUIET     = 0;
+  static constexpr int DOUBLEP   = 1;
+  static constexpr int CASTLE    = 2;
+  static constexpr int CAPTURE   = 4;
+  static constexpr int ENPASSANT = 5;
+  static constexpr int PROMO     = 8;
+
+  Move() = default; // trivial: MoveList no inicializa sus 256 entradas
+  constexpr Move(int from, int to, int flags = QUIET)
+    : data((uint16_t)(from | (to << 6) | (flags << 12))) {}
+
+  static constexpr Move none() { return Move(0, 0); }
+  static constexpr Move from_raw(uint16_t raw) { Move m(0, 0); m.data = raw; return m; }
+  static constexpr Move promotion(int from, int to, int promo, bool capture) {
+    return Move(from, to, PROMO | (capture ? CAPTURE : 0) | (promo - KNIGHT));
+  }
+
+  constexpr int from() const { return data & 63; }
+  constexpr int to() const { return (data >> 6) & 63; }
+  constexpr int flags() const { return data >> 12; }
+  constexpr int promo() const { return (flags() & PROMO) ? KNIGHT + (flags() & 3) : EMPTY; }
+  constexpr bool is_capture() const { return (flags() & CAPTURE) != 0; }
+  constexpr bool is_enpassant() const { return flags() == ENPASSANT; }
+  constexpr bool is_castle() const { return flags() == CASTLE; }
+  constexpr bool is_double_push() const { return flags() == DOUBLEP; }
+  constexpr bool is_null() const { return data == 0; }
+
+  constexpr bool operator==(const Move& o) const { return data == o.data; }
+  constexpr bool operator!=(const Move& o) const { return data != o.data; }
+};
+static_assert(sizeof(Move) == 2, "Move debe ocupar 16 bits");
+
+// Lista de jugadas en stack con score embebido (sin heap en la búsqueda).
+struct MoveList {
+  static constexpr int CAPACITY = 256; // máximo legal conocido: 218
+
+  Move moves[CAPACITY];
+  int32_t scores[CAPACITY];
+  int count = 0;
+
+  void clear() { count = 0; }
+  void push(Move m) { moves[count++] = m; }
+  int size() const { return count; }
+  bool empty() const { return count == 0; }
+
+  Move& operator[](int i) { return moves[i]; }
+  const Move& operator[](int i) const { return moves[i]; }
+  Move* begin() { return moves; }
+  Move* end() { return moves + count; }
+  const Move* begin() const { return moves; }
+  const Move* end() const { return moves + count; }
+
+  bool contains(Move m) const {
+    for (int i = 0; i < count; i++) if (moves[i] == m) return true;
+    return false;
+  }
+};
+
+inline string move_to_uci(const Move& m) {
+  string s;
+  s += sq_to_str(m.from());
+  s += sq_to_str(m.to());
+  if (m.promo() != EMPTY) s += promo_to_char(m.promo());
+  return s;
+}
+
+// ---------------- PST ----------------
+// Material + piece-square tables (medio juego / final) generadas en compilación.
+// Board las acumula en put_piece/remove_piece, así make/unmake mantienen el
+// término lineal de la evaluación sin recorrer el tablero.
+inline constexpr int PV[7] = {0, 100, 320, 330, 500, 900, 0};
+inline constexpr int PV_EG[7] = {0, 120, 300, 330, 520, 950, 0};
+
+// fase: 24 = todo el material de piezas en el tablero, 0 = solo reyes y peones
+inline constexpr int PHASE_WEIGHT[7] = {0, 0, 1, 1, 2, 4, 0};
+inline constexpr int PHASE_MAX = 24;
+
+struct PsqScore { int16_t mg, eg; };
+
+constexpr int center_bonus(int sq) {
+  // bonus por cercanía al centro (d4/e4/d5/e5)
+  int f = file_of(sq), r = rank_of(sq);
+  int df = (f > 3 ? f - 3 : 3 - f) + (f > 4 ? f - 4 : 4 - f);
+  int dr = (r > 3 ? r - 3 : 3 - r) + (r > 4 ? r - 4 : 4 - r);
+  int d = df < dr ? df : dr;
+  return (3 - (d < 3 ? d : 3)) * 6; // 0..18
+}
+
+// valor desde el punto de vista de blancas, sq relativo al bando (a1 = propia esquina)
+constexpr PsqScore psq_relative(int pt, int rsq) {
+  int mg = PV[pt], eg = PV_EG[pt];
+  switch (pt) {
+    case PAWN: {
+      int adv = rank_of(rsq);                 // avance relativo
+      mg += adv * 4;
+      eg += adv * 8;                          // en el final el avance pesa más
+      int f = file_of(rsq);
+      if (f == 3 || f == 4) mg += 8;          // peones centrales (d/e)
+      break;
+    }
+    case KNIGHT:
+    case BISHOP:
+      mg += center_bonus(rsq);                // centralización
+      eg += center_bonus(rsq) / 2;
+      break;
+    case KING:
+      eg += center_bonus(rsq);                // rey activo en el final
+      break;
+    default: break;
+  }
+  return {(int16_t)mg, (int16_t)eg};
+}
+
+// PSQT[color][pt][sq]: ya con signo (+blancas, -negras)
+inline constexpr auto PSQT = [] {
+  array<array<array<PsqScore, 64>, 7>, 2> t{};
+  for (int pt = PAWN; pt <= KING; pt++)
+    for (int s = 0; s < 64; s++) {
+      PsqScore w = psq_relative(pt, s);
+      t[WHITE][pt][s] = w;
+      t[BLACK][pt][s ^ 56] = {(int16_t)-w.mg, (int16_t)-w.eg};
+    }
+  return t;
+}();
+
+// ---------------- Board ----------------
+// Tipos de generación: CAPTURES incluye al paso y todas las promociones;
+// QUIETS el resto (avances, enroques). CAPTURES + QUIETS == ALL.
+// EVASIONS: todas las legales estando en jaque (rey, captura del atacante, interposición).
+enum GenType : int { GEN_ALL = 0, GEN_CAPTURES = 1, GEN_QUIETS = 2, GEN_EVASIONS = 3 };
+
+struct CastleInfo {
+  int right;          // bit de derechos (1=K,2=Q,4=k,8=q)
+  int kfrom, kto;     // casillas del rey
+  int rook;           // casilla inicial de la torre
+  Bitboard empty;     // casillas que deben estar vacías
+  int pass1, pass2;   // casillas que el rey no puede cruzar atacado
+  int8_t rookPiece;
+};
+
+inline constexpr CastleInfo CASTLES[4] = {
+  {1,  4,  6,  7, bb_sq(5)  | bb_sq(6),              5,  6, (int8_t)ROOK},
+  {2,  4,  2,  0, bb_sq(1)  | bb_sq(2)  | bb_sq(3),  3,  2, (int8_t)ROOK},
+  {4, 60, 62, 63, bb_sq(61) | bb_sq(62),            61, 62, (int8_t)-ROOK},
+  {8, 60, 58, 56, bb_sq(57) | bb_sq(58) | bb_sq(59), 59, 58, (int8_t)-ROOK},
+};
+
+struct Undo {
+  int8_t captured = 0;
+  int castling = 0;
+  int ep = -1;
+  int halfmove = 0;
+  int fullmove = 1;
+
+  int ep_cap_sq = -1;
+  int8_t ep_cap_piece = 0;
+
+  uint64_t key = 0;
+};
+
+struct Board {
+  array<int8_t, 64> sq{};                   // mailbox: pieza por casilla
+  array<array<Bitboard, 7>, 2> pieces{};    // [color][tipo de pieza], índice 0 sin uso
+  array<Bitboard, 2> occ{};                 // ocupación por color
+  Color side = WHITE;
+  int castling = 0; // 1=K,2=Q,4=k,8=q
+  int ep = -1;
+  int halfmove = 0;
+  int fullmove = 1;
+
+  uint64_t key = 0;
+  uint64_t pawn_key = 0;     // Zobrist solo de peones (pawn hash)
+  vector<uint64_t> key_hist; // for repetition
+
+  // eval incremental (ver PSQT)
+  int psq_mg = 0, psq_eg = 0;
+  int phase = 0;
+  NnueAccumulator acc;       // solo válido con NNUE_ON (ver nnue_refresh)
+
+  Board() { sq.fill(0); }
+
+  Bitboard occupied() const { return occ[WHITE] | occ[BLACK]; }
+
+  void put_piece(int s, int8_t p) {
+    Color c = color_of(p);
+    int pt = abs_piece(p);
+    sq[s] = p;
+    Bitboard b = bb_sq(s);
+    pieces[c][pt] |= b;
+    occ[c] |= b;
+    psq_mg += PSQT[c][pt][s].mg;
+    psq_eg += PSQT[c][pt][s].eg;
+    phase += PHASE_WEIGHT[pt];
+    if (pt == PAWN) pawn_key ^= Z_PIECE[pidx(p)][s];
+    if (NNUE_ON) nnue_add(acc, c, pt, s);
+  }
+
+  void remove_piece(int s) {
+    int8_t p = sq[s];
+    Color c = color_of(p);
+    int pt = abs_piece(p);
+    Bitboard b = bb_sq(s);
+    pieces[c][pt] &= ~b;
+    occ[c] &= ~b;
+    psq_mg -= PSQT[c][pt][s].mg;
+    psq_eg -= PSQT[c][pt][s].eg;
+    phase -= PHASE_WEIGHT[pt];
+    if (pt == PAWN) pawn_key ^= Z_PIECE[pidx(p)][s];
+    if (NNUE_ON) nnue_sub(acc, c, pt, s);
+    sq[s] = 0;
+  }
+
+  // Acumulador desde cero: al activar NNUE con el tablero ya armado
+  void nnue_refresh() {
+    for (int p = 0; p < 2; p++) memcpy(acc.v[p], NNUE_NET->ft_b, sizeof(acc.v[p]));
+    for (int s = 0; s < 64; s++)
+      if (sq[s]) nnue_add(acc, color_of(sq[s]), abs_piece(sq[s]), s);
+  }
+
+  void set_startpos() { set_fen(START_FEN); }
+
+  uint64_t compute_key() const {
+    uint64_t k = 0;
+    for (int i = 0; i < 64; i++) {
+      int8_t p = sq[i];
+      if (p) k ^= Z_PIECE[pidx(p)][i];
+    }
+    k ^= Z_CASTLE[castling & 15];
+    if (ep != -1) k ^= Z_EPFILE[file_of(ep)];
+    if (side == BLACK) k ^= Z_SIDE;
+    return k;
+  }
+
+  bool set_fen(const string& fen) {
+    sq.fill(0);
+    for (auto& c : pieces) c.fill(0);
+    occ.fill(0);
+    psq_mg = psq_eg = phase = 0;
+    pawn_key = 0;
+    if (NNUE_ON) for (int p = 0; p < 2; p++) memcpy(acc.v[p], NNUE_NET->ft_b, sizeof(acc.v[p]));
+    side = WHITE;
+    castling = 0;
+    ep = -1;
+    halfmove = 0;
+    fullmove = 1;
+
+    istringstream iss(fen);
+    string placement, stm, cast, eps;
+    if (!(iss >> placement >> stm >> cast >> eps >> halfmove >> fullmove)) return false;
+
+    int r = 7, f = 0;
+    for (char c : placement) {
+      if (c == '/') { r--; f = 0; continue; }
+      if (isdigit((unsigned char)c)) { f += (c - '0'); continue; }
+      if (!on_board(f, r)) return false;
+
+      Color pc = isupper((unsigned char)c) ? WHITE : BLACK;
+      char lc = (char)tolower((unsigned char)c);
+
+      int pt = EMPTY;
+      if (lc == 'p') pt = PAWN;
+      else if (lc == 'n') pt = KNIGHT;
+      else if (lc == 'b') pt = BISHOP;
+      else if (lc == 'r') pt = ROOK;
+      else if (lc == 'q') pt = QUEEN;
+      else if (lc == 'k') pt = KING;
+      else return false;
+
+      int8_t val = (int8_t)(pc == WHITE ? pt : -pt);
+      put_piece(sq_of(f, r), val);
+      f++;
+    }
+
+    side = (stm == "w") ? WHITE : BLACK;
+
+    castling = 0;
+    if (cast != "-") {
+      for (char c : cast) {
+        if (c == 'K') castling |= 1;
+        else if (c == 'Q') castling |= 2;
+        else if (c == 'k') castling |= 4;
+        else if (c == 'q') castling |= 8;
+      }
+    }
+
+    ep = (eps != "-") ? str_to_sq(eps) : -1;
+
+    key = compute_key();
+    key_hist.clear();
+    key_hist.push_back(key);
+    return true;
+  }
+
+  int find_king(Color c) const {
+    Bitboard k = pieces[c][KING];
+    return k ? lsb(k) : -1;
+  }
+
+  bool is_square_attacked(int target, Color by) const {
+    const auto& P = pieces[by];
+    // un peón de 'by' ataca target si target está en su patrón => mirar desde target con el color opuesto
+    if (PAWN_ATT[by ^ 1][target] & P[PAWN]) return true;
+    if (KNIGHT_ATT[target] & P[KNIGHT]) return true;
+    if (KING_ATT[target] & P[KING]) return true;
+
+    Bitboard all = occupied();
+    if (rook_attacks(target, all) & (P[ROOK] | P[QUEEN])) return true;
+    if (bishop_attacks(target, all) & (P[BISHOP] | P[QUEEN])) return true;
+    return false;
+  }
+
+  // Igual que is_square_attacked pero con una ocupación hipotética: las piezas
+  // fuera de 'occupancy' (capturadas / movidas) no cuentan como atacantes.
+  bool is_square_attacked(int target, Color by, Bitboard occupancy) const {
+    const auto& P = pieces[by];
+    if (PAWN_ATT[by ^ 1][target] & P[PAWN] & occupancy) return true;
+    if (KNIGHT_ATT[target] & P[KNIGHT] & occupancy) return true;
+    if (KING_ATT[target] & P[KING]) return true;
+    if (rook_attacks(target, occupancy) & (P[ROOK] | P[QUEEN]) & occupancy) return true;
+    if (bishop_attacks(target, occupancy) & (P[BISHOP] | P[QUEEN]) & occupancy) return true;
+    return false;
+  }
+
+  Bitboard attackers_to(int target, Color by) const {
+    const auto& P = pieces[by];
+    Bitboard all = occupied();
+    return (PAWN_ATT[by ^ 1][target] & P[PAWN])
+         | (KNIGHT_ATT[target] & P[KNIGHT])
+         | (KING_ATT[target] & P[KING])
+         | (rook_attacks(target, all) & (P[ROOK] | P[QUEEN]))
+         | (bishop_attacks(target, all) & (P[BISHOP] | P[QUEEN]));
+  }
+
+  // Atacantes de ambos colores con ocupación dada (para SEE / x-rays)
+  Bitboard attackers_to(int target, Bitboard occupancy) const {
+    return (PAWN_ATT[BLACK][target] & pieces[WHITE][PAWN])
+         | (PAWN_ATT[WHITE][target] & pieces[BLACK][PAWN])
+         | (KNIGHT_ATT[target] & (pieces[WHITE][KNIGHT] | pieces[BLACK][KNIGHT]))
+         | (KING_ATT[target] & (pieces[WHITE][KING] | pieces[BLACK][KING]))
+         | (rook_attacks(target, occupancy) & rooks_queens())
+         | (bishop_attacks(target, occupancy) & bishops_queens());
+  }
+
+  Bitboard rooks_queens() const {
+    return pieces[WHITE][ROOK] | pieces[WHITE][QUEEN] | pieces[BLACK][ROOK] | pieces[BLACK][QUEEN];
+  }
+  Bitboard bishops_queens() const {
+    return pieces[WHITE][BISHOP] | pieces[WHITE][QUEEN] | pieces[BLACK][BISHOP] | pieces[BLACK][QUEEN];
+  }
+
+  // Static Exchange Evaluation: ¿la secuencia de capturas en m.to() deja al
+  // que mueve (color de la pieza en from) con al menos threshold? Cada bando
+  // recaptura con su pieza de menor valor; al sacarla de la ocupación se suman
+  // los deslizantes que estaban detrás (x-rays). No considera clavadas.
+  bool see_ge(Move m, int threshold = 0) const {
+    // enroque / promoción / al paso: valor inmediato 0, no vale la pena el intercambio
+    if (m.is_castle() || m.promo() != EMPTY || m.is_enpassant()) return 0 >= threshold;
+
+    int from = m.from(), to = m.to();
+    int swap = PV[abs_piece(sq[to])] - threshold;
+    if (swap < 0) return false;
+    swap = PV[abs_piece(sq[from])] - swap;
+    if (swap <= 0) return true;
+
+    Bitboard occupancy = occupied() ^ bb_sq(from) ^ bb_sq(to);
+    Color stm = color_of(sq[from]);
+    Bitboard attackers = attackers_to(to, occupancy);
+    const Bitboard bq = bishops_queens(), rq = rooks_queens();
+    int res = 1;
+
+    while (true) {
+      stm = (stm == WHITE ? BLACK : WHITE);
+      attackers &= occupancy;
+      Bitboard stmAttackers = attackers & occ[stm];
+      if (!stmAttackers) break;
+      res ^= 1;
+
+      Bitboard bb;
+      if ((bb = stmAttackers & pieces[stm][PAWN])) {
+        if ((swap = PV[PAWN] - swap) < res) break;
+        occupancy ^= bb & -bb;
+        attackers |= bishop_attacks(to, occupancy) & bq;
+      } else if ((bb = stmAttackers & pieces[stm][KNIGHT])) {
+        if ((swap = PV[KNIGHT] - swap) < res) break;
+        occupancy ^= bb & -bb;
+      } else if ((bb = stmAttackers & pieces[stm][BISHOP])) {
+        if ((swap = PV[BISHOP] - swap) < res) break;
+        occupancy ^= bb & -bb;
+        attackers |= bishop_attacks(to, occupancy) & bq;
+      } else if ((bb = stmAttackers & pieces[stm][ROOK])) {
+        if ((swap = PV[ROOK] - swap) < res) break;
+        occupancy ^= bb & -bb;
+        attackers |= rook_attacks(to, occupancy) & rq;
+      } else if ((bb = stmAttackers & pieces[stm][QUEEN])) {
+        if ((swap = PV[QUEEN] - swap) < res) break;
+        occupancy ^= bb & -bb;
+        attackers |= (bishop_attacks(to, occupancy) & bq) | (rook_attacks(to, occupancy) & rq);
+      } else {
+        // rey: solo puede capturar si el rival no tiene más atacantes
+        return (attackers & ~occ[stm]) ? res ^ 1 : res;
+      }
+    }
+    return bool(res);
+  }
+
+  // Piezas propias clavadas contra el rey propio
+  Bitboard pinned_pieces(Color us, int ksq) const {
+    Color them = (us == WHITE ? BLACK : WHITE);
+    const auto& P = pieces[them];
+    Bitboard all = occupied();
+    Bitboard snipers = (rook_attacks(ksq, 0) & (P[ROOK] | P[QUEEN]))
+                     | (bishop_attacks(ksq, 0) & (P[BISHOP] | P[QUEEN]));
+    Bitboard pinned = 0;
+    while (snipers) {
+      int s = pop_lsb(snipers);
+      Bitboard blockers = BETWEEN_BB[ksq][s] & all;
+      if (blockers && !(blockers & (blockers - 1)) && (blockers & occ[us])) pinned |= blockers;
+    }
+    return pinned;
+  }
+
+  bool in_check(Color c) const {
+    int ksq = find_king(c);
+    if (ksq < 0) return false;
+    return is_square_attacked(ksq, (c == WHITE ? BLACK : WHITE));
+  }
+
+  void update_castling_rights_on_move(int from, int to, int8_t moved, int8_t captured) {
+    if (abs_piece(moved) == KING) {
+      if (color_of(moved) == WHITE) castling &= ~(1 | 2);
+      else castling &= ~(4 | 8);
+    }
+    if (abs_piece(moved) == ROOK) {
+      if (from == 0) castling &= ~2;
+      else if (from == 7) castling &= ~1;
+      else if (from == 56) castling &= ~8;
+      else if (from == 63) castling &= ~4;
+    }
+    if (captured && abs_piece(captured) == ROOK) {
+      if (to == 0) castling &= ~2;
+      else if (to == 7) castling &= ~1;
+      else if (to == 56) castling &= ~8;
+      else if (to == 63) castling &= ~4;
+    }
+  }
+
+  static void add_promotion_moves(MoveList& out, int from, int to, bool capture) {
+    out.push(Move::promotion(from, to, QUEEN, capture));
+    out.push(Move::promotion(from, to, ROOK, capture));
+    out.push(Move::promotion(from, to, BISHOP, capture));
+    out.push(Move::promotion(from, to, KNIGHT, capture));
+  }
+
+  // Enroque disponible (sin mirar jaque al rey: lo filtra el llamador)
+  bool can_castle(const CastleInfo& c) const {
+    Color them = (side == WHITE ? BLACK : WHITE);
+    return (castling & c.right) && !(occupied() & c.empty) && sq[c.rook] == c.rookPiece &&
+           !is_square_attacked(c.pass1, them) && !is_square_attacked(c.pass2, them);
+  }
+
+  // Generador legal: calcula jaques y clavadas una vez por nodo y emite solo
+  // jugadas legales (sin make/unmake de prueba). Agrega a 'out' sin limpiarla.
+  // En jaque siempre genera evasiones (el tipo pedido se ignora).
+  void generate(MoveList& out, GenType type) const {
+    if (side == WHITE) generate_for<WHITE>(out, type);
+    else generate_for<BLACK>(out, type);
+  }
+
+  void gen_legal(MoveList& out) const {
+    out.clear();
+    generate(out, GEN_ALL);
+  }
+
+  template <Color Us>
+  void generate_for(MoveList& out, GenType type) const {
+    const int ksq = find_king(Us);
+    if (ksq < 0) return;
+    const Bitboard checkers = attackers_to(ksq, Us == WHITE ? BLACK : WHITE);
+    if (checkers) { generate_moves<Us, GEN_EVASIONS>(out, ksq, checkers); return; }
+    switch (type) {
+      case GEN_CAPTURES: generate_moves<Us, GEN_CAPTURES>(out, ksq, 0); break;
+      case GEN_QUIETS:   generate_moves<Us, GEN_QUIETS>(out, ksq, 0); break;
+      default:           generate_moves<Us, GEN_ALL>(out, ksq, 0); break;
+    }
+  }
+
+  // Una instancia por (bando, tipo): if constexpr saca las ramas que no aplican.
+  // EVASIONS exige checkers != 0; el resto, checkers == 0.
+  template <Color Us, GenType Type>
+  void generate_moves(MoveList& out, int ksq, Bitboard checkers) const {
+    constexpr Color Them = (Us == WHITE ? BLACK : WHITE);
+    constexpr bool Evasions = (Type == GEN_EVASIONS);
+    constexpr bool Captures = (Type != GEN_QUIETS);
+    constexpr bool Quiets = (Type != GEN_CAPTURES);
+    constexpr int Up = (Us == WHITE) ? 8 : -8;
+    constexpr Bitboard PromoRank = (Us == WHITE) ? RANK_8_BB : RANK_1_BB;
+    constexpr Bitboard ThirdRank = (Us == WHITE) ? (RANK_1_BB << 16) : (RANK_1_BB << 40);
+
+    const Bitboard own = occ[Us];
+    const Bitboard enemy = occ[Them];
+    const Bitboard all = own | enemy;
+    const Bitboard empty = ~all;
+    Bitboard typeMask;
+    if constexpr (Type == GEN_CAPTURES) typeMask = enemy;
+    else if constexpr (Type == GEN_QUIETS) typeMask = empty;
+    else typeMask = ~own;
+
+    // Rey: la casilla destino no puede quedar atacada (quitando el rey de la ocupación)
+    for (Bitboard t = KING_ATT[ksq] & typeMask; t; ) {
+      int to = pop_lsb(t);
+      if (!is_square_attacked(to, Them, all ^ bb_sq(ksq)))
+        out.push(Move(ksq, to, (enemy & bb_sq(to)) ? Move::CAPTURE : Move::QUIET));
+    }
+
+    // En jaque simple: capturar al atacante o interponerse (doble jaque: solo el rey)
+    Bitboard checkMask = ~0ULL;
+    if constexpr (Evasions) {
+      if (checkers & (checkers - 1)) return;
+      checkMask = checkers | BETWEEN_BB[ksq][lsb(checkers)];
+    }
+
+    const Bitboard pinned = pinned_pieces(Us, ksq);
+    auto pin_ok = [&](int from, int to) {
+      return !(pinned & bb_sq(from)) || (LINE_BB[ksq][from] & bb_sq(to));
+    };
+
+    // Peones: avances en bloque por shift, capturas por tabla
+    const Bitboard pawns = pieces[Us][PAWN];
+    auto push_up = [](Bitboard b) {
+      if constexpr (Us == WHITE) return b << 8;
+      else return b >> 8;
+    };
+
+    Bitboard one = push_up(pawns) & empty;
+    if constexpr (Quiets) {
+      Bitboard two = push_up(one & ThirdRank) & empty & checkMask;
+      for (Bitboard b = one & checkMask & ~PromoRank; b; ) {
+        int to = pop_lsb(b);
+        if (pin_ok(to - Up, to)) out.push(Move(to - Up, to));
+      }
+      for (Bitboard b = two; b; ) {
+        int to = pop_lsb(b);
+        if (pin_ok(to - 2 * Up, to)) out.push(Move(to - 2 * Up, to, Move::DOUBLEP));
+      }
+    }
+    if constexpr (Captures) {
+      for (Bitboard b = one & checkMask & PromoRank; b; ) {
+        int to = pop_lsb(b);
+        if (pin_ok(to - Up, to)) add_promotion_moves(out, to - Up, to, false);
+      }
+      for (Bitboard b = pawns; b; ) {
+        int from = pop_lsb(b);
+        Bitboard att = PAWN_ATT[Us][from];
+        for (Bitboard c = att & enemy & checkMask; c; ) {
+          int to = pop_lsb(c);
+          if (!pin_ok(from, to)) continue;
+          if (bb_sq(to) & PromoRank) add_promotion_moves(out, from, to, true);
+          else out.push(Move(from, to, Move::CAPTURE));
+        }
+        if (ep != -1 && (att & bb_sq(ep)) && ep_is_legal(from, ksq)) out.push(Move(from, ep, Move::ENPASSANT));
+      }
+    }
+
+    // Piezas
+    const Bitboard targets = typeMask & checkMask;
+    generate_piece<KNIGHT, Us>(out, targets, all, enemy, ksq, pinned);
+    generate_piece<BISHOP, Us>(out, targets, all, enemy, ksq, pinned);
+    generate_piece<ROOK, Us>(out, targets, all, enemy, ksq, pinned);
+    generate_piece<QUEEN, Us>(out, targets, all, enemy, ksq, pinned);
+
+    // Enroque (sin jaque + casillas vacías y no atacadas)
+    if constexpr (Type == GEN_QUIETS || Type == GEN_ALL) {
+      constexpr int first = (Us == WHITE ? 0 : 2);
+      if (can_castle(CASTLES[first])) out.push(Move(CASTLES[first].kfrom, CASTLES[first].kto, Move::CASTLE));
+      if (can_castle(CASTLES[first + 1]))
+        out.push(Move(CASTLES[first + 1].kfrom, CASTLES[first + 1].kto, Move::CASTLE));
+    }
+  }
+
+  template <int Pt, Color Us>
+  void generate_piece(MoveList& out, Bitboard targetMask, Bitboard all, Bitboard enemy, int ksq,
+                      Bitboard pinned) const {
+    for (Bitboard b = pieces[Us][Pt]; b; ) {
+      int from = pop_lsb(b);
+      Bitboard targets = piece_attacks<Pt>(from, all) & targetMask;
+      if (pinned & bb_sq(from)) {
+        if constexpr (Pt == KNIGHT) continue;   // un caballo clavado no se mueve
+        else targets &= LINE_BB[ksq][from];
+      }
+      for (Bitboard t = targets; t; ) {
+        int to = pop_lsb(t);
+        out.push(Move(from, to, (enemy & bb_sq(to)) ? Move::CAPTURE : Move::QUIET));
+      }
+    }
+  }
+
+  // Al paso: simular la ocupación resultante (cubre clavadas horizontales
+  // de dos peones y el jaque del peón que avanzó dos casillas).
+  bool ep_is_legal(int from, int ksq) const {
+    Color them = (side == WHITE ? BLACK : WHITE);
+    int capSq = ep + (side == WHITE ? -8 : 8);
+    Bitboard after = (occupied() ^ bb_sq(from) ^ bb_sq(capSq)) | bb_sq(ep);
+    return !is_square_attacked(ksq, them, after);
+  }
+
+  // Valida una jugada de origen externo (TT, killers) sin generar la lista:
+  // coherencia de flags con el tablero + legalidad con jaques/clavadas.
+  bool is_legal(Move m) const {
+    if (m.is_null()) return false;
+    Color us = side;
+    Color them = (us == WHITE ? BLACK : WHITE);
+    const int from = m.from(), to = m.to();
+    const int8_t p = sq[from];
+    if (!p || color_of(p) != us) return false;
+    if (occ[us] & bb_sq(to)) return false;
+
+    const int pt = abs_piece(p);
+    const Bitboard all = occupied();
+    const int ksq = find_king(us);
+
+    if (m.is_castle()) {
+      if (pt != KING || in_check(us)) return false;
+      for (int i = (us == WHITE ? 0 : 2), e = i + 2; i < e; i++)
+        if (CASTLES[i].kfrom == from && CASTLES[i].kto == to) return can_castle(CASTLES[i]);
+      return false;
+    }
+
+    if (m.is_enpassant()) {
+      return pt == PAWN && to == ep && (PAWN_ATT[us][from] & bb_sq(to)) && ep_is_legal(from, ksq);
+    }
+
+    // flag de captura debe coincidir con el contenido de 'to'
+    if (m.is_capture() != ((occ[them] & bb_sq(to)) != 0)) return false;
+
+    if (pt == PAWN) {
+      const int up = (us == WHITE) ? 8 : -8;
+      const bool lastRank = (bb_sq(to) & (RANK_1_BB | RANK_8_BB)) != 0;
+      if (lastRank != (m.promo() != EMPTY)) return false;
+      if (m.is_capture()) {
+        if (!(PAWN_ATT[us][from] & bb_sq(to))) return false;
+      } else if (m.is_double_push()) {
+        const int startRank = (us == WHITE) ? 1 : 6;
+        if (rank_of(from) != startRank || to != from + 2 * up || (all & bb_sq(from + up))) return false;
+        if (all & bb_sq(to)) return false;
+      } else {
+        if (to != from + up || (all & bb_sq(to))) return false;
+      }
+    } else {
+      if (m.promo() != EMPTY || m.is_double_push()) return false;
+      if (pt == KING) return (KING_ATT[from] & bb_sq(to)) && !is_square_attacked(to, them, all ^ bb_sq(from));
+      if (!(piece_attacks(pt, from, all) & bb_sq(to))) return false;
+    }
+
+    Bitboard checkers = attackers_to(ksq, them);
+    if (checkers) {
+      if (checkers & (checkers - 1)) return false;
+      if (!((checkers | BETWEEN_BB[ksq][lsb(checkers)]) & bb_sq(to))) return false;
+    }
+    if ((pinned_pieces(us, ksq) & bb_sq(from)) && !(LINE_BB[ksq][from] & bb_sq(to))) return false;
+    return true;
+  }
+
+  void make_move(const Move& m, Undo& u) {
+    u.captured = sq[m.to()];
+    u.castling = castling;
+    u.ep = ep;
+    u.halfmove = halfmove;
+    u.fullmove = fullmove;
+    u.ep_cap_sq = -1;
+    u.ep_cap_piece = 0;
+    u.key = key;
+
+    int8_t moved = sq[m.from()];
+    int8_t captured = sq[m.to()];
+
+    // Remove old state hashes
+    key ^= Z_CASTLE[castling & 15];
+    if (ep != -1) key ^= Z_EPFILE[file_of(ep)];
+
+    // Halfmove
+    if (abs_piece(moved) == PAWN || m.is_capture()) halfmove = 0;
+    else halfmove++;
+
+    if (side == BLACK) fullmove++;
+
+    // Clear ep by default
+    ep = -1;
+
+    // Piece hash: remove moved from 'from'
+    key ^= Z_PIECE[pidx(moved)][m.from()];
+
+    // Capture handling
+    if (m.is_enpassant()) {
+      int capSq = (side == WHITE) ? (m.to() - 8) : (m.to() + 8);
+      u.ep_cap_sq = capSq;
+      u.ep_cap_piece = sq[capSq];
+      // remove captured pawn hash
+      key ^= Z_PIECE[pidx(u.ep_cap_piece)][capSq];
+      remove_piece(capSq);
+      captured = u.ep_cap_piece;
+    } else if (captured) {
+      key ^= Z_PIECE[pidx(captured)][m.to()];
+      remove_piece(m.to());
+    }
+
+    // Move piece on board
+    remove_piece(m.from());
+
+    // Promotion
+    if (m.promo() != EMPTY) {
+      int8_t prom = (int8_t)(side == WHITE ? m.promo() : -m.promo());
+      put_piece(m.to(), prom);
+      key ^= Z_PIECE[pidx(prom)][m.to()];
+    } else {
+      put_piece(m.to(), moved);
+      key ^= Z_PIECE[pidx(moved)][m.to()];
+    }
+
+    // Castling rook move
+    if (m.is_castle()) {
+      auto move_rook = [&](int rf, int rt) {
+        int8_t rook = sq[rf];
+        key ^= Z_PIECE[pidx(rook)][rf];
+        remove_piece(rf);
+        put_piece(rt, rook);
+        key ^= Z_PIECE[pidx(rook)][rt];
+      };
+      if (m.to() == 6) move_rook(7, 5);         // white O-O
+      else if (m.to() == 2) move_rook(0, 3);    // white O-O-O
+      else if (m.to() == 62) move_rook(63, 61); // black O-O
+      else if (m.to() == 58) move_rook(56, 59); // black O-O-O
+    }
+
+    // Update castling rights
+    update_castling_rights_on_move(m.from(), m.to(), moved, captured);
+
+    // Double pawn push ep
+    if (m.is_double_push()) {
+      ep = (side == WHITE) ? (m.from() + 8) : (m.from() - 8);
+    }
+
+    // Add new state hashes
+    key ^= Z_CASTLE[castling & 15];
+    if (ep != -1) key ^= Z_EPFILE[file_of(ep)];
+
+    // Toggle side
+    side = (side == WHITE ? BLACK : WHITE);
+    key ^= Z_SIDE;
+
+    key_hist.push_back(key);
+  }
+
+  bool has_non_pawn_material(Color c) const {
+    return (occ[c] & ~(pieces[c][PAWN] | pieces[c][KING])) != 0;
+  }
+
+  void make_null(Undo& u) {
+    u.castling = castling;
+    u.ep = ep;
+    u.halfmove = halfmove;
+    u.fullmove = fullmove;
+    u.key = key;
+
+    // remove old state hashes
+    key ^= Z_CASTLE[castling & 15];
+    if (ep != -1) key ^= Z_EPFILE[file_of(ep)];
+
+    ep = -1;
+    halfmove++;
+
+    // add new state hashes
+    key ^= Z_CASTLE[castling & 15];
+    // ep none
+    side = (side == WHITE ? BLACK : WHITE);
+    key ^= Z_SIDE;
+
+    key_hist.push_back(key);
+  }
+
+  void unmake_null(const Undo& u) {
+    side = (side == WHITE ? BLACK : WHITE); // restore side toggle effect
+    castling = u.castling;
+    ep = u.ep;
+    halfmove = u.halfmove;
+    fullmove = u.fullmove;
+    key = u.key;
+    key_hist.pop_back();
+  }
+
+  void unmake_move(const Move& m, const Undo& u) {
+    // restore by reversing board state the same as before
+    side = (side == WHITE ? BLACK : WHITE);
+
+    castling = u.castling;
+    ep = u.ep;
+    halfmove = u.halfmove;
+    fullmove = u.fullmove;
+
+    // undo castling rook
+    if (m.is_castle()) {
+      auto move_rook = [&](int rf, int rt) {
+        int8_t rook = sq[rt];
+        remove_piece(rt);
+        put_piece(rf, rook);
+      };
+      if (m.to() == 6) move_rook(7, 5);
+      else if (m.to() == 2) move_rook(0, 3);
+      else if (m.to() == 62) move_rook(63, 61);
+      else if (m.to() == 58) move_rook(56, 59);
+    }
+
+    int8_t movedBack = sq[m.to()];
+
+    if (m.promo() != EMPTY) movedBack = (int8_t)(side == WHITE ? PAWN : -PAWN);
+
+    remove_piece(m.to());
+    put_piece(m.from(), movedBack);
+    if (u.captured) put_piece(m.to(), u.captured);
+
+    if (m.is_enpassant()) {
+      put_piece(u.ep_cap_sq, u.ep_cap_piece);
+    }
+
+    key = u.key;
+    key_hist.pop_back();
+  }
+
+  bool is_repetition() const {
+    // check repetition for same side-to-move positions; limit scan by halfmove (irreversible bound)
+    int reps = 0;
+    int limit = halfmove; // upper bound
+    // Compare only positions with same side to move => step by 2 plies
+    for (int i = (int)key_hist.size() - 1 - 2, steps = 0; i >= 0 && steps <= limit; i -= 2, steps += 2) {
+      if (key_hist[i] == key) {
+        reps++;
+        if (reps >= 2) return true; // current + two previous occurrences => threefold
+      }
+    }
+    return false;
+  }
+};
+
+// ---------------- Perft ----------------
+uint64_t perft_parallel(const Board& root, int depth, int threads, int hashMb,
+                        vector<pair<Move, uint64_t>>* perMove = nullptr);
+void perft_divide(const Board& b, int depth, int threads, int hashMb);
+
+// ---------------- Eval ----------------
+// Material y PST vienen incrementales del Board; acá solo los términos no lineales.
+constexpr Bitboard adjacent_files_bb(int f) {
+  return (f > 0 ? file_bb(f - 1) : 0) | (f < 7 ? file_bb(f + 1) : 0);
+}
+
+// Pawn hash: la estructura de peones cambia poco dentro de la búsqueda, así que
+// su evaluación se cachea por pawn_key. Una tabla por thread de búsqueda (sin locks).
+struct PawnEntry {
+  uint64_t key = 0;
+  int32_t score = 0;   // perspectiva blancas
+};
+
+struct PawnTable {
+  static constexpr size_t SIZE = 1 << 14;   // 16K entradas, 256 KB
+  vector<PawnEntry> t = vector<PawnEntry>(SIZE);
+
+  PawnEntry& operator[](uint64_t k) { return t[k & (SIZE - 1)]; }
+};
+
+int eval(const Board& b, PawnTable& pawns);
+
+
+// ---------------- TT ----------------
+inline constexpr int MATE = 30000;
+static_assert(NNUE_MAX_EVAL <= MATE - 1000, "la eval NNUE no puede caer en el rango de mate");
+inline constexpr int INF  = 32000;
+
+inline bool is_mate_score(int s) { return s > MATE - 1000 || s < -MATE + 1000; }
+// Jugadas hasta el mate (negativo si nos dan mate); solo para is_mate_score(s)
+inline int mate_in_moves(int s) { return s > 0 ? (MATE - s + 1) / 2 : -(MATE + s) / 2; }
+
+inline int score_to_tt(int s, int ply) {
+  if (s > MATE - 1000) return s + ply;
+  if (s < -MATE + 1000) return s - ply;
+  return s;
+}
+inline int score_from_tt(int s, int ply) {
+  if (s > MATE - 1000) return s - ply;
+  if (s < -MATE + 1000) return s + ply;
+  return s;
+}
+
+enum TTFlag : uint8_t { TT_EXACT = 0, TT_ALPHA = 1, TT_BETA = 2 };
+
+// ---------------- Large-page memory ----------------
+// Memoria para tablas grandes (TT): huge pages explícitas (MAP_HUGETLB) si el
+// sistema tiene reservadas, si no THP vía madvise; en hosts NUMA se intercala
+// entre nodos para que todos los threads vean la misma latencia promedio.
+struct LargeBlock {
+  void* ptr = nullptr;
+  size_t bytes = 0;
+  bool mmapped = false;
+};
+
+LargeBlock large_alloc(size_t bytes);
+void large_free(LargeBlock& blk);
+void parallel_zero(void* p, size_t bytes);
+
+struct TTHit {
+  int depth = 0;
+  int flag = TT_EXACT;
+  int score = 0;
+  Move best = Move::none();
+};
+
+// Entrada empaquetada en una palabra de 64 bits, leída/escrita con una sola
+// operación atómica (lock-free para Lazy SMP, sin lecturas "rotas"):
+//   key16 (16) | move (16) | score (16) | depth+1 (8) | bound (2) | generation (6)
+// depth8 == 0 marca la entrada vacía. Cluster de 4 entradas = 32 bytes.
+struct alignas(32) TTCluster {
+  static constexpr int SIZE = 4;
+  uint64_t e[SIZE];
+};
+static_assert(sizeof(TTCluster) == 32, "TTCluster debe ocupar 32 bytes");
+
+struct TranspositionTable {
+  static constexpr int GEN_BITS = 6;
+  static constexpr int GEN_CYCLE = 1 << GEN_BITS;
+
+  TTCluster* table = nullptr;
+  size_t count = 0;             // clusters
+  LargeBlock mem;
+  atomic<uint8_t> generation{0};  // atómico: en modo serve varias búsquedas hacen new_search a la vez
+
+  TranspositionTable() = default;
+  TranspositionTable(const TranspositionTable&) = delete;
+  TranspositionTable& operator=(const TranspositionTable&) = delete;
+  ~TranspositionTable() { large_free(mem); }
+
+  size_t size() const { return count; }
+
+  static uint16_t w_key(uint64_t w)   { return (uint16_t)w; }
+  static uint16_t w_move(uint64_t w)  { return (uint16_t)(w >> 16); }
+  static int16_t  w_score(uint64_t w) { return (int16_t)(w >> 32); }
+  static int      w_depth8(uint64_t w){ return (int)((w >> 48) & 0xFF); }
+  static int      w_bound(uint64_t w) { return (int)((w >> 56) & 3); }
+  static int      w_gen(uint64_t w)   { return (int)(w >> 58); }
+
+  static uint64_t pack(uint16_t k16, Move best, int score, int depth8, int bound, int gen) {
+    return (uint64_t)k16
+         | ((uint64_t)best.data << 16)
+         | ((uint64_t)(uint16_t)(int16_t)score << 32)
+         | ((uint64_t)(depth8 & 0xFF) << 48)
+         | ((uint64_t)(bound & 3) << 56)
+         | ((uint64_t)(gen & (GEN_CYCLE - 1)) << 58);
+  }
+
+  // Edad relativa a la búsqueda actual (0 = escrita en este "go")
+  int gen() const { return generation.load(memory_order_relaxed); }
+  int relative_age(uint64_t w) const { return (GEN_CYCLE + gen() - w_gen(w)) & (GEN_CYCLE - 1); }
+
+  static uint64_t load(const uint64_t& slot) {
+    return atomic_ref<uint64_t>(const_cast<uint64_t&>(slot)).load(memory_order_relaxed);
+  }
+  static void save(uint64_t& slot, uint64_t w) {
+    atomic_ref<uint64_t>(slot).store(w, memory_order_relaxed);
+  }
+
+  // Mismo tamaño: solo limpia (sin munmap/mmap). Distinto: realoca.
+  void resize_mb(int mb) {
+    if (mb < 1) mb = 1;
+    size_t n = (size_t)mb * 1024ULL * 1024ULL / sizeof(TTCluster);
+    if (n != count) {
+      large_free(mem);
+      table = nullptr;
+      count = 0;
+      mem = large_alloc(n * sizeof(TTCluster));
+      if (!mem.ptr) return;
+      table = static_cast<TTCluster*>(mem.ptr);
+      count = n;
+    }
+    clear();
+  }
+
+  // ucinewgame: vaciar sin realocar
+  void clear() {
+    if (table) parallel_zero(table, count * sizeof(TTCluster));
+    generation.store(0, memory_order_relaxed);
+  }
+
+  // Un "go" nuevo: las entradas de búsquedas anteriores envejecen
+  void new_search() {
+    uint8_t g = generation.load(memory_order_relaxed);
+    while (!generation.compare_exchange_weak(g, (uint8_t)((g + 1) & (GEN_CYCLE - 1)), memory_order_relaxed)) {}
+  }
+
+  // Índice por multiplicación alta: usa todo el tamaño (no requiere potencia de 2)
+  TTCluster* cluster(uint64_t k) const {
+    size_t idx = (size_t)(((unsigned __int128)k * (unsigned __int128)count) >> 64);
+    return &table[idx];
+  }
+
+  // Ocupación en por mil (UCI hashfull): muestra de los primeros 1000 clusters,
+  // solo entradas escritas o tocadas en esta búsqueda.
+  int hashfull() const {
+    size_t n = min<size_t>(count, 1000);
+    if (!n) return 0;
+    const int g = gen();
+    size_t used = 0;
+    for (size_t i = 0; i < n; i++)
+      for (int j = 0; j < TTCluster::SIZE; j++) {
+        uint64_t w = load(table[i].e[j]);
+        if (w_depth8(w) != 0 && w_gen(w) == g) used++;
+      }
+    return (int)(used * 1000 / (n * TTCluster::SIZE));
+  }
+
+  void prefetch(uint64_t k) const {
+    if (count) __builtin_prefetch(cluster(k));
+  }
+
+  bool probe(uint64_t k, TTHit& out) const {
+    if (!count) return false;
+    TTCluster* c = cluster(k);
+    const uint16_t k16 = (uint16_t)k;
+    for (int i = 0; i < TTCluster::SIZE; i++) {
+      uint64_t w = load(c->e[i]);
+      if (w_depth8(w) == 0 || w_key(w) != k16) continue;
+
+      // refrescar la generación para que no la desplacen como vieja
+      const int g = gen();
+      if (w_gen(w) != g)
+        save(c->e[i], pack(k16, Move::from_raw(w_move(w)), w_score(w), w_depth8(w), w_bound(w), g));
+
+      out.best  = Move::from_raw(w_move(w));
+      out.score = w_score(w);
+      out.depth = w_depth8(w) - 1;
+      out.flag  = w_bound(w);
+      return true;
+    }
+    return false;
+  }
+
+  // Reemplazo: misma posición si está en el cluster; si no, la entrada con
+  // menor depth - 8 * edad (las viejas y poco profundas se van primero).
+  void store(uint64_t k, int depth, int flag, int score, Move best) {
+    if (!count) return;
+    TTCluster* c = cluster(k);
+    const uint16_t k16 = (uint16_t)k;
+
+    uint64_t* slot = &c->e[0];
+    uint64_t old = load(*slot);
+    bool same = false;
+    int worst = INT_MAX;
+    for (int i = 0; i < TTCluster::SIZE; i++) {
+      uint64_t w = load(c->e[i]);
+      if (w_depth8(w) == 0 || w_key(w) == k16) {
+        slot = &c->e[i];
+        old = w;
+        same = w_depth8(w) != 0;
+        break;
+      }
+      int value = w_depth8(w) - 8 * relative_age(w);
+      if (value < worst) {
+        worst = value;
+        slot = &c->e[i];
+        old = w;
+      }
+    }
+
+    if (same) {
+      // conservar la jugada vieja si la nueva búsqueda no produjo ninguna
+      if (best.is_null()) best = Move::from_raw(w_move(old));
+      // no pisar una entrada más profunda de esta misma búsqueda con un bound peor
+      if (flag != TT_EXACT && depth + 1 + 3 < w_depth8(old) && relative_age(old) == 0) return;
+    }
+
+    save(*slot, pack(k16, best, score, depth + 1, flag, gen()));
+  }
+};
+
+inline TranspositionTable TT;
+
+// ---------------- Search ----------------
+// Presupuesto de tiempo por jugada. soft: objetivo que el iterative deepening
+// ajusta según estabilidad (no arranca una iteración que no va a terminar);
+// hard: deadline absoluto que corta la búsqueda. 0 = sin límite.
+struct TimeBudget {
+  int soft_ms = 0;
+  int hard_ms = 0;
+};
+
+// Salida UCI (líneas completas, thread-safe). Con buffer: flush=false (líneas
+// "info") solo vuelca cada tanto; el resto se vuelca enseguida.
+void uci_send(const string& line, bool flush = true);
+void uci_flush();
+
+// Destino alternativo de uci_send (WASM: cada línea va al Web Worker); nullptr = cout.
+// Se llama con el mutex de salida tomado, desde cualquier thread.
+inline void (*UCI_OUTPUT_HOOK)(const string& line) = nullptr;
+
+// ---------------- Nivel de juego ----------------
+// Skill Level 0..19: presupuesto de nodos y profundidad (se corta apenas se agota)
+// y elección con ruido entre las SKILL_MULTI_PV mejores de la raíz, más ruido
+// cuanto más bajo el nivel. MAX_SKILL = fuerza completa.
+inline constexpr int MAX_SKILL = 20;
+inline constexpr int SKILL_MULTI_PV = 4;
+inline constexpr int MIN_ELO = 800;
+inline constexpr int MAX_ELO = 2800;
+
+struct SkillBudget {
+  uint64_t nodes = 0;   // 0 = sin límite
+  int depth = 0;
+};
+
+// nodos x2 cada dos niveles: 1024 (nivel 0, un poll de búsqueda) a 512K (nivel 19)
+inline SkillBudget skill_budget(int level) {
+  if (level >= MAX_SKILL) return {};
+  level = max(level, 0);
+  return {1024ULL << (level / 2), 1 + level / 2};
+}
+
+// UCI_Elo -> nivel (lineal en [MIN_ELO, MAX_ELO]); con UCI_LimitStrength siempre < MAX_SKILL
+inline int skill_from_elo(int elo) {
+  return clamp((elo - MIN_ELO) * MAX_SKILL / (MAX_ELO - MIN_ELO), 0, MAX_SKILL - 1);
+}
+
+// Límites de una búsqueda, modificables desde otro thread (stop, ponderhit).
+struct SearchControl {
+  static constexpr int64_t NO_DEADLINE = INT64_MAX;
+
+  atomic<bool> stop{false};
+  atomic<bool> ponder{false};                 // mientras pondera no corre el reloj
+  atomic<int64_t> deadline{NO_DEADLINE};      // steady_clock ticks
+  atomic<uint64_t> node_limit{0};             // "go nodes N"; 0 = sin límite
+  atomic<int64_t> start{0};                   // inicio del reloj (go o ponderhit)
+  atomic<int> soft_ms{0};                     // objetivo del time manager; 0 = no aplica
+  bool quiet = false;                         // sin líneas "info" (bench); fijar antes de buscar
+  atomic<bool> debug{false};                  // UCI "debug on": agrega "info string stats"; reset() no lo toca
+  int threads = 0;                            // threads de esta búsqueda; 0 = SEARCH_THREADS
+  int multipv = 1;                            // UCI MultiPV: líneas de raíz a reportar
+  int skill = MAX_SKILL;                      // nivel efectivo (Skill Level / UCI_Elo)
+  string tag;                                 // prefijo de cada línea de salida ("session 3 ")
+  TranspositionTable* tt = nullptr;           // TT propia (analyze); nullptr = TT global
+
+  void send(const string& line, bool flush = true) const {
+    uci_send(tag.empty() ? line : tag + line, flush);
+  }
+
+  static int64_t now_ticks() { return chrono::steady_clock::now().time_since_epoch().count(); }
+
+  void reset() {
+    stop.store(false);
+    ponder.store(false);
+    deadline.store(NO_DEADLINE);
+    node_limit.store(0);
+    start.store(now_ticks());
+    soft_ms.store(0);
+  }
+
+  // movetime_ms <= 0: sin límite de tiempo
+  void set_movetime(int movetime_ms) {
+    if (movetime_ms <= 0) { deadline.store(NO_DEADLINE); return; }
+    auto d = chrono::steady_clock::now() + chrono::milliseconds(movetime_ms);
+    deadline.store(d.time_since_epoch().count());
+  }
+
+  // Arranca el reloj ahora con el presupuesto dado
+  void set_limits(const TimeBudget& tb) {
+    start.store(now_ticks());
+    soft_ms.store(tb.soft_ms);
+    set_movetime(tb.hard_ms);
+  }
+
+  int64_t elapsed_ms() const {
+    auto d = chrono::steady_clock::duration(now_ticks() - start.load(memory_order_relaxed));
+    return chrono::duration_cast<chrono::milliseconds>(d).count();
+  }
+
+  bool expired() const {
+    if (stop.load(memory_order_relaxed)) return true;
+    if (ponder.load(memory_order_relaxed)) return false;
+    int64_t d = deadline.load(memory_order_relaxed);
+    return d != NO_DEADLINE && now_ticks() >= d;
+  }
+};
+
+void init_search_tables();
+
+#if defined(SEARCH_STATS)
+inline constexpr bool SEARCH_STATS_ENABLED = true;
+#else
+inline constexpr bool SEARCH_STATS_ENABLED = false;
+#endif
+
+inline int SEARCH_THREADS = 1;
+
+// ---------------- Syzygy ----------------
+// Tablas de finales vía Fathom (opcional: BM_SYZYGY + FATHOM_DIR; sin
+// USE_SYZYGY no hay tablas). Fathom mapea cada archivo recién al primer uso
+// y lo comparte entre threads y sesiones.
+inline int SYZYGY_PROBE_LIMIT = 7;   // piezas máximas para cortar en búsqueda (WDL)
+
+// Carga las tablas de 'path' (separador ':'); "" o "<empty>" las libera.
+// Devuelve la cantidad máxima de piezas disponible (0 = sin tablas).
+int syzygy_init(const string& path);
+int syzygy_largest();
+
+// ---------------- Cache persistente ----------------
+// Resultados de búsquedas terminadas (depth, score, jugada, bound) por Board::key
+// en un archivo mapeado MAP_SHARED: lo comparten los bm_engine del host y
+// sobrevive reinicios. Entradas key ^ data como la TT, sin locks (una escritura
+// cruzada entre procesos no valida y se descarta). La clave no ve la historia:
+// con halfmove >= 50 no se usa.
+struct CachedResult {
+  Move best = Move::none();
+  int score = 0;          // cp desde el que mueve (mate relativo a la raíz)
+  int depth = 0;          // última iteración completa
+  TTFlag bound = TT_EXACT;
+};
+
+// Profundidad mínima para contestar un "go" sin depth fijo (tiempo / nodos)
+inline int SEARCH_CACHE_MIN_DEPTH = 12;
+
+// Abre (o crea con 'mb' megas) el archivo; uno existente se usa con su tamaño.
+// false (y 'err') si no se puede mapear o el formato no coincide.
+// Abrir / cerrar solo sin búsquedas en curso.
+bool search_cache_open(const string& path, int mb, string& err);
+void search_cache_close();
+bool search_cache_is_open();
+
+bool search_cache_probe(const Board& b, int minDepth, CachedResult& out);
+void search_cache_store(const Board& b, const CachedResult& r);
+
+// "cp X" o "mate N" para info score
+string score_to_uci(int s);
+
+// Posiciones fijas de bench (apertura / medio juego / final / táctica)
+extern const vector<string> BENCH_FENS;
+
+// outDepth: última iteración completa (0 si no buscó: tablas / sin jugadas)
+Move search_bestmove(Board& b, const SearchControl& ctl, int maxDepth, int& outScoreCp,
+                     uint64_t* outNodes = nullptr, int* outDepth = nullptr);
@@ -1,726 +1,16 @@
-#include <iostream>
-#include <string>
-#include <vector>
-#include <array>
-#include <sstream>
-#include <cctype>
-#include <algorithm>
-#include <chrono>
-#include <cstdint>
+#include "engine.h"
 
-#include "opening_book.h"
-
-using namespace std;
-
-enum Color : int { WHITE = 0, BLACK = 1 };
-
-enum PieceType : int {
-  EMPTY = 0,
-  PAWN = 1,
-  KNIGHT = 2,
-  BISHOP = 3,
-  ROOK = 4,
-  QUEEN = 5,
-  KING = 6
-};
-
-// piece encoding: 0 empty, +1..+6 white, -1..-6 black
-static inline Color color_of(int8_t p) { return p > 0 ? WHITE : BLACK; }
-static inline int abs_piece(int8_t p) { return p >= 0 ? p : -p; }
-
-static inline int file_of(int sq) { return sq & 7; }
-static inline int rank_of(int sq) { return sq >> 3; }
-static inline bool on_board(int f, int r) { return f >= 0 && f < 8 && r >= 0 && r < 8; }
-static inline int sq_of(int f, int r) { return r * 8 + f; }
-
-static inline string sq_to_str(int sq) {
-  string s = "a1";
-  s[0] = char('a' + file_of(sq));
-  s[1] = char('1' + rank_of(sq));
-  return s;
-}
-static inline int str_to_sq(const string& s) {
-  if (s.size() != 2) return -1;
-  int f = s[0] - 'a';
-  int r = s[1] - '1';
-  if (!on_board(f, r)) return -1;
-  return sq_of(f, r);
-}
-
-static inline char promo_to_char(int promo) {
-  switch (promo) {
-    case QUEEN: return 'q';
-    case ROOK:  return 'r';
-    case BISHOP:return 'b';
-    case KNIGHT:return 'n';
-    default:    return '\0';
-  }
-}
-static inline int char_to_promo(char c) {
-  c = (char)tolower((unsigned char)c);
-  if (c == 'q') return QUEEN;
-  if (c == 'r') return ROOK;
-  if (c == 'b') return BISHOP;
-  if (c == 'n') return KNIGHT;
-  return EMPTY;
-}
-
-static const string START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
-
-// Precomputed step moves
-static array<vector<int>, 64> KNIGHT_STEPS;
-static array<vector<int>, 64> KING_STEPS;
-static array<array<vector<int>, 64>, 2> PAWN_ATTACKS;
-
-static void init_attack_tables() {
-  for (int sq = 0; sq < 64; sq++) {
-    int f = file_of(sq), r = rank_of(sq);
-
-    static const int kdf[8] = { -2,-1, 1, 2, 2, 1,-1,-2 };
-    static const int kdr[8] = {  1, 2, 2, 1,-1,-2,-2,-1 };
-    for (int i = 0; i < 8; i++) {
-      int nf = f + kdf[i], nr = r + kdr[i];
-      if (on_board(nf, nr)) KNIGHT_STEPS[sq].push_back(sq_of(nf, nr));
-    }
-
-    for (int df = -1; df <= 1; df++) {
-      for (int dr = -1; dr <= 1; dr++) {
-        if (df == 0 && dr == 0) continue;
-        int nf = f + df, nr = r + dr;
-        if (on_board(nf, nr)) KING_STEPS[sq].push_back(sq_of(nf, nr));
-      }
-    }
-
-    if (on_board(f - 1, r + 1)) PAWN_ATTACKS[WHITE][sq].push_back(sq_of(f - 1, r + 1));
-    if (on_board(f + 1, r + 1)) PAWN_ATTACKS[WHITE][sq].push_back(sq_of(f + 1, r + 1));
-    if (on_board(f - 1, r - 1)) PAWN_ATTACKS[BLACK][sq].push_back(sq_of(f - 1, r - 1));
-    if (on_board(f + 1, r - 1)) PAWN_ATTACKS[BLACK][sq].push_back(sq_of(f + 1, r - 1));
-  }
-}
-
-// ---------------- Zobrist ----------------
-static array<array<uint64_t, 64>, 12> Z_PIECE; // 12 piece kinds
-static array<uint64_t, 16> Z_CASTLE;
-static array<uint64_t, 8>  Z_EPFILE;
-static uint64_t Z_SIDE;
-
-static inline int pidx(int8_t p) {
-  int ap = abs_piece(p);
-  if (p > 0) return ap - 1;          // 0..5
-  return 6 + (ap - 1);              // 6..11
-}
-
-// SplitMix64 RNG
-static inline uint64_t splitmix64(uint64_t &x) {
-  uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
-  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
-  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
-  return z ^ (z >> 31);
-}
-
-static void init_zobrist(uint64_t seed = 0xC0FFEEULL) {
-  uint64_t x = seed;
-  for (int i = 0; i < 12; i++)
-    for (int sq = 0; sq < 64; sq++)
-      Z_PIECE[i][sq] = splitmix64(x);
-
-  for (int i = 0; i < 16; i++) Z_CASTLE[i] = splitmix64(x);
-  for (int i = 0; i < 8; i++)  Z_EPFILE[i] = splitmix64(x);
-  Z_SIDE = splitmix64(x);
-}
-
-// ---------------- Move ----------------
-struct Move {
-  int from = 0;
-  int to = 0;
-  int promo = EMPTY;
-  uint8_t flags = 0;
-
-  static constexpr uint8_t CAPTURE   = 1 << 0;
-  static constexpr uint8_t ENPASSANT = 1 << 1;
-  static constexpr uint8_t CASTLE    = 1 << 2;
-  static constexpr uint8_t DOUBLEP   = 1 << 3;
-  static constexpr uint8_t PROMO     = 1 << 4;
-};
-
-static inline string move_to_uci(const Move& m) {
-  string s;
-  s += sq_to_str(m.from);
-  s += sq_to_str(m.to);
-  if (m.promo != EMPTY) s += promo_to_char(m.promo);
-  return s;
-}
-
-static inline uint32_t encode_move(const Move& m) {
-  // from (6) | to (6) | promo (3)
-  uint32_t p = (m.promo == EMPTY) ? 0u : (uint32_t)m.promo; // 2..5 mostly
-  return (uint32_t)m.from | ((uint32_t)m.to << 6) | (p << 12);
-}
-static inline Move decode_move(uint32_t em) {
-  Move m;
-  m.from = (int)(em & 63u);
-  m.to   = (int)((em >> 6) & 63u);
-  uint32_t p = (em >> 12) & 7u;
-  m.promo = (p == 0 ? EMPTY : (int)p);
-  m.flags = 0;
-  return m;
-}
-
-// ---------------- Board ----------------
-struct Undo {
-  int8_t captured = 0;
-  int castling = 0;
-  int ep = -1;
-  int halfmove = 0;
-  int fullmove = 1;
-
-  int ep_cap_sq = -1;
-  int8_t ep_cap_piece = 0;
-
-  uint64_t key = 0;
-};
-
-struct Board {
-  array<int8_t, 64> sq{};
-  Color side = WHITE;
-  int castling = 0; // 1=K,2=Q,4=k,8=q
-  int ep = -1;
-  int halfmove = 0;
-  int fullmove = 1;
-
-  uint64_t key = 0;
-  vector<uint64_t> key_hist; // for repetition
-
-  Board() { sq.fill(0); }
-
-  void set_startpos() { set_fen(START_FEN); }
-
-  uint64_t compute_key() const {
-    uint64_t k = 0;
-    for (int i = 0; i < 64; i++) {
-      int8_t p = sq[i];
-      if (p) k ^= Z_PIECE[pidx(p)][i];
-    }
-    k ^= Z_CASTLE[castling & 15];
-    if (ep != -1) k ^= Z_EPFILE[file_of(ep)];
-    if (side == BLACK) k ^= Z_SIDE;
-    return k;
-  }
-
-  bool set_fen(const string& fen) {
-    sq.fill(0);
-    side = WHITE;
-    castling = 0;
-    ep = -1;
-    halfmove = 0;
-    fullmove = 1;
-
-    istringstream iss(fen);
-    string placement, stm, cast, eps;
-    if (!(iss >> placement >> stm >> cast >> eps >> halfmove >> fullmove)) return false;
-
-    int r = 7, f = 0;
-    for (char c : placement) {
-      if (c == '/') { r--; f = 0; continue; }
-      if (isdigit((unsigned char)c)) { f += (c - '0'); continue; }
-      if (!on_board(f, r)) return false;
-
-      Color pc = isupper((unsigned char)c) ? WHITE : BLACK;
-      char lc = (char)tolower((unsigned char)c);
-
-      int pt = EMPTY;
-      if (lc == 'p') pt = PAWN;
-      else if (lc == 'n') pt = KNIGHT;
-      else if (lc == 'b') pt = BISHOP;
-      else if (lc == 'r') pt = ROOK;
-      else if (lc == 'q') pt = QUEEN;
-      else if (lc == 'k') pt = KING;
-      else return false;
-
-      int8_t val = (int8_t)(pc == WHITE ? pt : -pt);
-      sq[sq_of(f, r)] = val;
-      f++;
-    }
-
-    side = (stm == "w") ? WHITE : BLACK;
-
-    castling = 0;
-    if (cast != "-") {
-      for (char c : cast) {
-        if (c == 'K') castling |= 1;
-        else if (c == 'Q') castling |= 2;
-        else if (c == 'k') castling |= 4;
-        else if (c == 'q') castling |= 8;
-      }
-    }
-
-    ep = (eps != "-") ? str_to_sq(eps) : -1;
-
-    key = compute_key();
-    key_hist.clear();
-    key_hist.push_back(key);
-    return true;
-  }
-
-  int find_king(Color c) const {
-    int8_t k = (int8_t)(c == WHITE ? KING : -KING);
-    for (int i = 0; i < 64; i++) if (sq[i] == k) return i;
-    return -1;
-  }
-
-  bool is_square_attacked(int target, Color by) const {
-    int tf = file_of(target), tr = rank_of(target);
-
-    if (by == WHITE) {
-      int r = tr - 1;
-      if (r >= 0) {
-        if (tf - 1 >= 0) { int s = sq_of(tf - 1, r); if (sq[s] == (int8_t)PAWN) return true; }
-        if (tf + 1 < 8)  { int s = sq_of(tf + 1, r); if (sq[s] == (int8_t)PAWN) return true; }
-      }
-    } else {
-      int r = tr + 1;
-      if (r < 8) {
-        if (tf - 1 >= 0) { int s = sq_of(tf - 1, r); if (sq[s] == (int8_t)(-PAWN)) return true; }
-        if (tf + 1 < 8)  { int s = sq_of(tf + 1, r); if (sq[s] == (int8_t)(-PAWN)) return true; }
-      }
-    }
-
-    for (int s : KNIGHT_STEPS[target]) {
-      int8_t p = sq[s];
-      if (p && abs_piece(p) == KNIGHT && color_of(p) == by) return true;
-    }
-
-    for (int s : KING_STEPS[target]) {
-      int8_t p = sq[s];
-      if (p && abs_piece(p) == KING && color_of(p) == by) return true;
-    }
-
-    static const int dR[4][2] = { {0,1},{0,-1},{1,0},{-1,0} };
-    for (auto &d : dR) {
-      int f = tf + d[0], r = tr + d[1];
-      while (on_board(f, r)) {
-        int s = sq_of(f, r);
-        int8_t p = sq[s];
-        if (p) {
-          if (color_of(p) == by) {
-            int ap = abs_piece(p);
-            if (ap == ROOK || ap == QUEEN) return true;
-          }
-          break;
-        }
-        f += d[0]; r += d[1];
-      }
-    }
-
-    static const int dB[4][2] = { {1,1},{-1,1},{1,-1},{-1,-1} };
-    for (auto &d : dB) {
-      int f = tf + d[0], r = tr + d[1];
-      while (on_board(f, r)) {
-        int s = sq_of(f, r);
-        int8_t p = sq[s];
-        if (p) {
-          if (color_of(p) == by) {
-            int ap = abs_piece(p);
-            if (ap == BISHOP || ap == QUEEN) return true;
-          }
-          break;
-        }
-        f += d[0]; r += d[1];
-      }
-    }
-
-    return false;
-  }
-
-  bool in_check(Color c) const {
-    int ksq = find_king(c);
-    if (ksq < 0) return false;
-    return is_square_attacked(ksq, (c == WHITE ? BLACK : WHITE));
-  }
-
-  void update_castling_rights_on_move(int from, int to, int8_t moved, int8_t captured) {
-    if (abs_piece(moved) == KING) {
-      if (color_of(moved) == WHITE) castling &= ~(1 | 2);
-      else castling &= ~(4 | 8);
-    }
-    if (abs_piece(moved) == ROOK) {
-      if (from == 0) castling &= ~2;
-      else if (from == 7) castling &= ~1;
-      else if (from == 56) castling &= ~8;
-      else if (from == 63) castling &= ~4;
-    }
-    if (captured && abs_piece(captured) == ROOK) {
-      if (to == 0) castling &= ~2;
-      else if (to == 7) castling &= ~1;
-      else if (to == 56) castling &= ~8;
-      else if (to == 63) castling &= ~4;
-    }
-  }
-
-  void add_promotion_moves(vector<Move>& out, int from, int to, uint8_t baseFlags) const {
-    Move m;
-    m.from = from; m.to = to; m.flags = baseFlags | Move::PROMO;
-    m.promo = QUEEN;  out.push_back(m);
-    m.promo = ROOK;   out.push_back(m);
-    m.promo = BISHOP; out.push_back(m);
-    m.promo = KNIGHT; out.push_back(m);
-  }
-
-  void gen_pseudo_legal(vector<Move>& out) const {
-    out.clear();
-    Color us = side;
-    Color them = (us == WHITE ? BLACK : WHITE);
-
-    for (int from = 0; from < 64; from++) {
-      int8_t p = sq[from];
-      if (!p || color_of(p) != us) continue;
-
-      int pt = abs_piece(p);
-      int f = file_of(from), r = rank_of(from);
-
-      if (pt == PAWN) {
-        if (us == WHITE) {
-          int one = from + 8;
-          if (one < 64 && sq[one] == 0) {
-            if (rank_of(one) == 7) add_promotion_moves(out, from, one, 0);
-            else {
-              out.push_back(Move{from, one, EMPTY, 0});
-              if (r == 1) {
-                int two = from + 16;
-                if (sq[two] == 0) out.push_back(Move{from, two, EMPTY, Move::DOUBLEP});
-              }
-            }
-          }
-          for (int to : PAWN_ATTACKS[WHITE][from]) {
-            if (sq[to] && color_of(sq[to]) == them) {
-              uint8_t fl = Move::CAPTURE;
-              if (rank_of(to) == 7) add_promotion_moves(out, from, to, fl);
-              else out.push_back(Move{from, to, EMPTY, fl});
-            }
-            if (to == ep) out.push_back(Move{from, to, EMPTY, (uint8_t)(Move::ENPASSANT | Move::CAPTURE)});
-          }
-        } else {
-          int one = from - 8;
-          if (one >= 0 && sq[one] == 0) {
-            if (rank_of(one) == 0) add_promotion_moves(out, from, one, 0);
-            else {
-              out.push_back(Move{from, one, EMPTY, 0});
-              if (r == 6) {
-                int two = from - 16;
-                if (sq[two] == 0) out.push_back(Move{from, two, EMPTY, Move::DOUBLEP});
-              }
-            }
-          }
-          for (int to : PAWN_ATTACKS[BLACK][from]) {
-            if (sq[to] && color_of(sq[to]) == them) {
-              uint8_t fl = Move::CAPTURE;
-              if (rank_of(to) == 0) add_promotion_moves(out, from, to, fl);
-              else out.push_back(Move{from, to, EMPTY, fl});
-            }
-            if (to == ep) out.push_back(Move{from, to, EMPTY, (uint8_t)(Move::ENPASSANT | Move::CAPTURE)});
-          }
-        }
-      }
-      else if (pt == KNIGHT) {
-        for (int to : KNIGHT_STEPS[from]) {
-          int8_t q = sq[to];
-          if (!q) out.push_back(Move{from, to, EMPTY, 0});
-          else if (color_of(q) == them) out.push_back(Move{from, to, EMPTY, Move::CAPTURE});
-        }
-      }
-      else if (pt == BISHOP || pt == ROOK || pt == QUEEN) {
-        static const int dB[4][2] = { {1,1},{-1,1},{1,-1},{-1,-1} };
-        static const int dR[4][2] = { {0,1},{0,-1},{1,0},{-1,0} };
-
-        auto slide = [&](int df, int dr) {
-          int nf = f + df, nr = r + dr;
-          while (on_board(nf, nr)) {
-            int to = sq_of(nf, nr);
-            if (!sq[to]) out.push_back(Move{from, to, EMPTY, 0});
-            else {
-              if (color_of(sq[to]) == them) out.push_back(Move{from, to, EMPTY, Move::CAPTURE});
-              break;
-            }
-            nf += df; nr += dr;
-          }
-        };
-
-        if (pt == BISHOP || pt == QUEEN) for (auto &d : dB) slide(d[0], d[1]);
-        if (pt == ROOK   || pt == QUEEN) for (auto &d : dR) slide(d[0], d[1]);
-      }
-      else if (pt == KING) {
-        for (int to : KING_STEPS[from]) {
-          int8_t q = sq[to];
-          if (!q) out.push_back(Move{from, to, EMPTY, 0});
-          else if (color_of(q) == them) out.push_back(Move{from, to, EMPTY, Move::CAPTURE});
-        }
+#include <fstream>
+#include <condition_variable>
+#include <unordered_map>
+#include <deque>
+#include <iomanip>
 
-        // Castling (requires not in check + squares empty + squares not attacked)
-        if (us == WHITE) {
-          if (!in_check(WHITE)) {
-            if ((castling & 1) && sq[5] == 0 && sq[6] == 0 && sq[7] == (int8_t)ROOK) {
-              if (!is_square_attacked(5, BLACK) && !is_square_attacked(6, BLACK))
-                out.push_back(Move{4, 6, EMPTY, Move::CASTLE});
-            }
-            if ((castling & 2) && sq[3] == 0 && sq[2] == 0 && sq[1] == 0 && sq[0] == (int8_t)ROOK) {
-              if (!is_square_attacked(3, BLACK) && !is_square_attacked(2, BLACK))
-                out.push_back(Move{4, 2, EMPTY, Move::CASTLE});
-            }
-          }
-        } else {
-          if (!in_check(BLACK)) {
-            if ((castling & 4) && sq[61] == 0 && sq[62] == 0 && sq[63] == (int8_t)(-ROOK)) {
-              if (!is_square_attacked(61, WHITE) && !is_square_attacked(62, WHITE))
-                out.push_back(Move{60, 62, EMPTY, Move::CASTLE});
-            }
-            if ((castling & 8) && sq[59] == 0 && sq[58] == 0 && sq[57] == 0 && sq[56] == (int8_t)(-ROOK)) {
-              if (!is_square_attacked(59, WHITE) && !is_square_attacked(58, WHITE))
-                out.push_back(Move{60, 58, EMPTY, Move::CASTLE});
-            }
-          }
-        }
-      }
-    }
-  }
-
-  void gen_legal(vector<Move>& out) {
-    vector<Move> pseudo;
-    gen_pseudo_legal(pseudo);
-    out.clear();
-
-    Color us = side;
-    for (const auto& m : pseudo) {
-      Undo u;
-      make_move(m, u);
-      bool ok = !in_check(us);
-      unmake_move(m, u);
-      if (ok) out.push_back(m);
-    }
-  }
-
-  void make_move(const Move& m, Undo& u) {
-    u.captured = sq[m.to];
-    u.castling = castling;
-    u.ep = ep;
-    u.halfmove = halfmove;
-    u.fullmove = fullmove;
-    u.ep_cap_sq = -1;
-    u.ep_cap_piece = 0;
-    u.key = key;
-
-    int8_t moved = sq[m.from];
-    int8_t captured = sq[m.to];
-
-    // Remove old state hashes
-    key ^= Z_CASTLE[castling & 15];
-    if (ep != -1) key ^= Z_EPFILE[file_of(ep)];
-
-    // Halfmove
-    if (abs_piece(moved) == PAWN || (m.flags & Move::CAPTURE)) halfmove = 0;
-    else halfmove++;
-
-    if (side == BLACK) fullmove++;
-
-    // Clear ep by default
-    ep = -1;
-
-    // Piece hash: remove moved from 'from'
-    key ^= Z_PIECE[pidx(moved)][m.from];
-
-    // Capture handling
-    if (m.flags & Move::ENPASSANT) {
-      int capSq = (side == WHITE) ? (m.to - 8) : (m.to + 8);
-      u.ep_cap_sq = capSq;
-      u.ep_cap_piece = sq[capSq];
-      // remove captured pawn hash
-      key ^= Z_PIECE[pidx(u.ep_cap_piece)][capSq];
-      sq[capSq] = 0;
-      captured = u.ep_cap_piece;
-    } else if (captured) {
-      key ^= Z_PIECE[pidx(captured)][m.to];
-    }
-
-    // Move piece on board
-    sq[m.to] = moved;
-    sq[m.from] = 0;
-
-    // Promotion
-    if (m.promo != EMPTY) {
-      int8_t prom = (int8_t)(side == WHITE ? m.promo : -m.promo);
-      sq[m.to] = prom;
-      key ^= Z_PIECE[pidx(prom)][m.to];
-    } else {
-      key ^= Z_PIECE[pidx(moved)][m.to];
-    }
-
-    // Castling rook move
-    if (m.flags & Move::CASTLE) {
-      if (m.to == 6) { // white O-O
-        int8_t rook = sq[7];
-        key ^= Z_PIECE[pidx(rook)][7];
-        sq[5] = rook; sq[7] = 0;
-        key ^= Z_PIECE[pidx(rook)][5];
-      } else if (m.to == 2) { // white O-O-O
-        int8_t rook = sq[0];
-        key ^= Z_PIECE[pidx(rook)][0];
-        sq[3] = rook; sq[0] = 0;
-        key ^= Z_PIECE[pidx(rook)][3];
-      } else if (m.to == 62) { // black O-O
-        int8_t rook = sq[63];
-        key ^= Z_PIECE[pidx(rook)][63];
-        sq[61] = rook; sq[63] = 0;
-        key ^= Z_PIECE[pidx(rook)][61];
-      } else if (m.to == 58) { // black O-O-O
-        int8_t rook = sq[56];
-        key ^= Z_PIECE[pidx(rook)][56];
-        sq[59] = rook; sq[56] = 0;
-        key ^= Z_PIECE[pidx(rook)][59];
-      }
-    }
-
-    // Update castling rights
-    update_castling_rights_on_move(m.from, m.to, moved, captured);
-
-    // Double pawn push ep
-    if (m.flags & Move::DOUBLEP) {
-      ep = (side == WHITE) ? (m.from + 8) : (m.from - 8);
-    }
-
-    // Add new state hashes
-    key ^= Z_CASTLE[castling & 15];
-    if (ep != -1) key ^= Z_EPFILE[file_of(ep)];
-
-    // Toggle side
-    side = (side == WHITE ? BLACK : WHITE);
-    key ^= Z_SIDE;
-
-    key_hist.push_back(key);
-  }
-
-  bool has_non_pawn_material(Color c) const {
-  for (int i = 0; i < 64; i++) {
-    int8_t p = sq[i];
-    if (!p) continue;
-    if (color_of(p) != c) continue;
-    int ap = abs_piece(p);
-    if (ap != KING && ap != PAWN) return true;
-    }
-    return false;
-  }
-
-  void make_null(Undo& u) {
-    u.castling = castling;
-    u.ep = ep;
-    u.halfmove = halfmove;
-    u.fullmove = fullmove;
-    u.key = key;
-
-    // remove old state hashes
-    key ^= Z_CASTLE[castling & 15];
-    if (ep != -1) key ^= Z_EPFILE[file_of(ep)];
-
-    ep = -1;
-    halfmove++;
-
-    // add new state hashes
-    key ^= Z_CASTLE[castling & 15];
-    // ep none
-    side = (side == WHITE ? BLACK : WHITE);
-    key ^= Z_SIDE;
-
-    key_hist.push_back(key);
-  }
-
-  void unmake_null(const Undo& u) {
-    side = (side == WHITE ? BLACK : WHITE); // restore side toggle effect
-    castling = u.castling;
-    ep = u.ep;
-    halfmove = u.halfmove;
-    fullmove = u.fullmove;
-    key = u.key;
-    key_hist.pop_back();
-  }
-
-  void unmake_move(const Move& m, const Undo& u) {
-    // restore by reversing board state the same as before
-    side = (side == WHITE ? BLACK : WHITE);
-
-    castling = u.castling;
-    ep = u.ep;
-    halfmove = u.halfmove;
-    fullmove = u.fullmove;
-
-    // undo castling rook
-    if (m.flags & Move::CASTLE) {
-      if (m.to == 6) { sq[7] = sq[5]; sq[5] = 0; }
-      else if (m.to == 2) { sq[0] = sq[3]; sq[3] = 0; }
-      else if (m.to == 62) { sq[63] = sq[61]; sq[61] = 0; }
-      else if (m.to == 58) { sq[56] = sq[59]; sq[59] = 0; }
-    }
-
-    int8_t movedBack = sq[m.to];
-
-    if (m.promo != EMPTY) movedBack = (int8_t)(side == WHITE ? PAWN : -PAWN);
-
-    sq[m.from] = movedBack;
-    sq[m.to] = u.captured;
-
-    if (m.flags & Move::ENPASSANT) {
-      sq[m.to] = 0;
-      sq[u.ep_cap_sq] = u.ep_cap_piece;
-    }
-
-    key = u.key;
-    key_hist.pop_back();
-  }
-
-  bool is_repetition() const {
-    // check repetition for same side-to-move positions; limit scan by halfmove (irreversible bound)
-    int reps = 0;
-    int limit = halfmove; // upper bound
-    // Compare only positions with same side to move => step by 2 plies
-    for (int i = (int)key_hist.size() - 1 - 2, steps = 0; i >= 0 && steps <= limit; i -= 2, steps += 2) {
-      if (key_hist[i] == key) {
-        reps++;
-        if (reps >= 2) return true; // current + two previous occurrences => threefold
-      }
-    }
-    return false;
-  }
-};
-
-// ---------------- Perft ----------------
-static uint64_t perft(Board& b, int depth) {
-  if (depth == 0) return 1ULL;
-  vector<Move> moves;
-  b.gen_legal(moves);
-
-  uint64_t nodes = 0;
-  for (const auto& m : moves) {
-    Undo u;
-    b.make_move(m, u);
-    nodes += perft(b, depth - 1);
-    b.unmake_move(m, u);
-  }
-  return nodes;
-}
-
-static void perft_divide(Board& b, int depth) {
-  vector<Move> moves;
-  b.gen_legal(moves);
-
-  uint64_t total = 0;
-  for (const auto& m : moves) {
-    Undo u;
-    b.make_move(m, u);
-    uint64_t n = perft(b, depth - 1);
-    b.unmake_move(m, u);
-    cout << move_to_uci(m) << ": " << n << "\n";
-    total += n;
-  }
-  cout << "Total: " << total << "\n";
-}
+#include "opening_book.h"
 
+#if defined(BM_WASM_API)
+#include <emscripten.h>
+#endif
 
 // ---------------- UCI helpers ----------------
 static vector<string> split_ws(const string& s) {
@@ -732,17 +22,19 @@ static vector<string> split_ws(const string& s) {
 }
 
 static bool apply_uci_move(Board& b, const string& uci) {
-  if (uci.size() < 4) return false;
-  int from = str_to_sq(uci.substr(0,2));
-  int to = str_to_sq(uci.substr(2,2));
+  if (uci.size() < 4 || uci.size() > 5) return false;
+  int ff = uci[0] - 'a', fr = uci[1] - '1', tf = uci[2] - 'a', tr = uci[3] - '1';
+  if (!on_board(ff, fr) || !on_board(tf, tr)) return false;
+  int from = sq_of(ff, fr);
+  int to = sq_of(tf, tr);
   int promo = (uci.size() == 5) ? char_to_promo(uci[4]) : EMPTY;
 
-  vector<Move> moves;
+  MoveList moves;
   b.gen_legal(moves);
 
   for (const auto& m : moves) {
-    if (m.from == from && m.to == to) {
-      if ((m.promo == EMPTY && promo == EMPTY) || (m.promo != EMPTY && m.promo == promo)) {
+    if (m.from() == from && m.to() == to) {
+      if (m.promo() == promo) {
         Undo u;
         b.make_move(m, u);
         return true;
@@ -752,35 +44,103 @@ static bool apply_uci_move(Board& b, const string& uci) {
   return false;
 }
 
-static void uci_position(Board& b, const string& line, vector<string>& move_history) {
+// SAN (PGN) -> jugada legal: "Nbd7", "exd5", "e8=Q+", "O-O-O". none si no es legal o es ambigua.
+static Move parse_san(const Board& b, string san) {
+  while (!san.empty() && strchr("+#!?", san.back())) san.pop_back();
+  if (san.empty()) return Move::none();
+
+  MoveList legal;
+  b.gen_legal(legal);
+
+  if (san == "O-O" || san == "0-0" || san == "O-O-O" || san == "0-0-0") {
+    int kto = (san.size() == 3) ? 6 : 2;   // archivo g / c
+    for (const auto& m : legal)
+      if (m.is_castle() && file_of(m.to()) == kto) return m;
+    return Move::none();
+  }
+
+  int promo = EMPTY;
+  size_t eq = san.find('=');
+  if (eq != string::npos) {
+    if (eq + 1 < san.size()) promo = char_to_promo(san[eq + 1]);
+    san.resize(eq);
+  } else if (san.size() >= 3 && strchr("QRBN", san.back()) && isdigit((unsigned char)san[san.size() - 2])) {
+    promo = char_to_promo(san.back());     // "e8Q"
+    san.pop_back();
+  }
+
+  int pt = PAWN;
+  if (const char* p = strchr("NBRQK", san[0]); p && *p) {
+    pt = KNIGHT + (int)(p - "NBRQK");
+    san.erase(0, 1);
+  }
+  san.erase(remove(san.begin(), san.end(), 'x'), san.end());
+  if (san.size() < 2) return Move::none();
+
+  int to = str_to_sq(san.substr(san.size() - 2));
+  if (to < 0) return Move::none();
+  int fromFile = -1, fromRank = -1;
+  for (size_t i = 0; i + 2 < san.size(); i++) {
+    char c = san[i];
+    if (c >= 'a' && c <= 'h') fromFile = c - 'a';
+    else if (c >= '1' && c <= '8') fromRank = c - '1';
+  }
+
+  Move found = Move::none();
+  for (const auto& m : legal) {
+    if (m.to() != to || m.promo() != promo || abs_piece(b.sq[m.from()]) != pt) continue;
+    if (fromFile >= 0 && file_of(m.from()) != fromFile) continue;
+    if (fromRank >= 0 && rank_of(m.from()) != fromRank) continue;
+    if (!found.is_null()) return Move::none();   // ambigua
+    found = m;
+  }
+  return found;
+}
+
+// 'base' recuerda de dónde sale el tablero actual ("startpos" o el FEN): si el
+// nuevo "position" tiene la misma base y su lista extiende move_history (lo
+// normal en una partida, el cliente manda siempre la lista entera) se aplican
+// solo las jugadas nuevas. Cualquier otra cosa (takeback, otra partida) rehace todo.
+static void uci_position(Board& b, const string& line, string& base, vector<string>& move_history) {
   auto tok = split_ws(line);
   if (tok.size() < 2) return;
 
-  move_history.clear();
-
   size_t i = 1;
+  string newBase;
   if (tok[i] == "startpos") {
-    b.set_startpos();
+    newBase = "startpos";
     i++;
   } else if (tok[i] == "fen") {
     if (tok.size() < i + 7) return;
-    string fen = tok[i+1] + " " + tok[i+2] + " " + tok[i+3] + " " + tok[i+4] + " " + tok[i+5] + " " + tok[i+6];
-    b.set_fen(fen);
+    newBase = tok[i+1] + " " + tok[i+2] + " " + tok[i+3] + " " + tok[i+4] + " " + tok[i+5] + " " + tok[i+6];
     i += 7;
   } else return;
 
-  if (i < tok.size() && tok[i] == "moves") {
-    i++;
-    for (; i < tok.size(); i++) {
-      if (apply_uci_move(b, tok[i])) move_history.push_back(tok[i]);
-    }
+  size_t first = i;   // primera jugada de la lista
+  if (i < tok.size() && tok[i] == "moves") first = ++i;
+  size_t nmoves = tok.size() - first;
+
+  bool extends = !base.empty() && newBase == base && nmoves >= move_history.size() &&
+                 equal(move_history.begin(), move_history.end(), tok.begin() + (ptrdiff_t)first);
+  if (extends) {
+    i = first + move_history.size();
+  } else {
+    move_history.clear();
+    base = newBase;
+    if (base == "startpos") b.set_startpos();
+    else if (!b.set_fen(base)) base.clear();   // FEN inválido: no reusar
+    i = first;
+  }
+
+  for (; i < tok.size(); i++) {
+    if (apply_uci_move(b, tok[i])) move_history.push_back(tok[i]);
   }
 }
 
-static bool has_critical_tactics(Board& b, const vector<Move>& legal) {
+static bool has_critical_tactics(Board& b, const MoveList& legal) {
   if (b.in_check(b.side)) return true;
   for (const auto& m : legal) {
-    if ((m.flags & Move::CAPTURE) || m.promo != EMPTY) return true;
+    if (m.is_capture() || m.promo() != EMPTY) return true;
   }
   return false;
 }
@@ -803,573 +163,1321 @@ struct GoParams {
   int depth = 0;          // 0 => iterative until time
   int movetime_ms = 0;    // 0 => derive from clocks
   int wtime = -1, btime = -1, winc = 0, binc = 0;
+  int movestogo = 0;      // 0 => sudden death
+  bool infinite = false;  // buscar hasta "stop"
+  bool ponder = false;    // buscar en el tiempo del rival hasta "ponderhit"/"stop"
+  uint64_t nodes = 0;     // 0 => sin límite de nodos
 };
 
 static GoParams parse_go(const string& line) {
   GoParams p;
   auto tok = split_ws(line);
-  for (size_t i = 0; i + 1 < tok.size(); i++) {
+  for (size_t i = 0; i < tok.size(); i++) {
+    if (tok[i] == "infinite") p.infinite = true;
+    else if (tok[i] == "ponder") p.ponder = true;
+    if (i + 1 >= tok.size()) break;
     if (tok[i] == "depth") p.depth = stoi(tok[i+1]);
     else if (tok[i] == "movetime") p.movetime_ms = stoi(tok[i+1]);
     else if (tok[i] == "wtime") p.wtime = stoi(tok[i+1]);
     else if (tok[i] == "btime") p.btime = stoi(tok[i+1]);
     else if (tok[i] == "winc") p.winc = stoi(tok[i+1]);
     else if (tok[i] == "binc") p.binc = stoi(tok[i+1]);
+    else if (tok[i] == "nodes") p.nodes = stoull(tok[i+1]);
+    else if (tok[i] == "movestogo") p.movestogo = stoi(tok[i+1]);
   }
   return p;
 }
 
-static int choose_movetime_ms(const Board& b, const GoParams& p) {
-  if (p.movetime_ms > 0) return p.movetime_ms;
+static constexpr int MOVE_OVERHEAD_MS = 20;   // latencia GUI / red
+static constexpr int DEFAULT_MOVES_TO_GO = 28;
+
+static TimeBudget choose_time_budget(const Board& b, const GoParams& p) {
+  TimeBudget tb;
+  if (p.movetime_ms > 0) { tb.hard_ms = p.movetime_ms; return tb; }
 
   int rem = (b.side == WHITE ? p.wtime : p.btime);
   int inc = (b.side == WHITE ? p.winc : p.binc);
-  if (rem <= 0) return 200;
+  if (rem <= 0) { tb.hard_ms = 200; return tb; }
 
-  // Blitz-friendly: usa ~1/28 del reloj + una fracción del increment, con clamps.
-  int t = rem / 28 + inc / 2;
-  t = max(30, min(1200, t));
-  return t;
-}
+  int avail = max(1, rem - MOVE_OVERHEAD_MS);
+  int mtg = p.movestogo > 0 ? min(p.movestogo, 50) : DEFAULT_MOVES_TO_GO;
 
-// ---------------- Eval ----------------
-static constexpr int PV[7] = {0, 100, 320, 330, 500, 900, 0};
+  // nunca más del 80% de lo que queda, ni siquiera con movestogo 1
+  int cap = max(1, avail * 8 / 10);
+  tb.soft_ms = min(cap, avail / mtg + inc * 3 / 4);
+  tb.hard_ms = min(cap, tb.soft_ms * 3);
+  tb.soft_ms = max(1, tb.soft_ms);
+  return tb;
+}
 
-static inline int center_bonus(int sq) {
-  // bonus por cercanía al centro (d4/e4/d5/e5)
-  int f = file_of(sq), r = rank_of(sq);
-  int df = abs(f - 3) + abs(f - 4);
-  int dr = abs(r - 3) + abs(r - 4);
-  int d = min(df, dr);
-  return (3 - min(3, d)) * 6; // 0..18
+// ---------------- UCI search thread ----------------
+static SearchControl SEARCH_CTL;
+static thread SEARCH_THREAD;
+static TimeBudget PONDER_BUDGET;   // presupuesto a usar desde "ponderhit"
+
+static constexpr int MAX_SEARCH_DEPTH = 64;
+static constexpr int MAX_MULTI_PV = 16;
+
+// Hash del modo UCI: en el navegador el heap WASM es chico (y compartido con la página)
+#if defined(__EMSCRIPTEN__)
+static constexpr int DEFAULT_HASH_MB = 16;
+static constexpr int MAX_HASH_MB = 256;
+#else
+static constexpr int DEFAULT_HASH_MB = 64;
+static constexpr int MAX_HASH_MB = 2048;
+#endif
+static constexpr int MAX_UCI_THREADS = HAS_THREADS ? 32 : 1;
+
+static int parse_multipv(const string& line) {
+  auto tok = split_ws(line);
+  return clamp(atoi(tok.back().c_str()), 1, MAX_MULTI_PV);
 }
 
-static int eval(const Board& b) {
-  int score = 0;
+// Skill Level / UCI_LimitStrength / UCI_Elo -> SearchControl::skill
+struct StrengthOptions {
+  int level = MAX_SKILL;
+  bool limit = false;
+  int elo = MAX_ELO;
 
-  int wpawns_file[8] = {0}, bpawns_file[8] = {0};
-  bool wB = false, wB2 = false, bB = false, bB2 = false;
-
-  int wKingSq = -1, bKingSq = -1;
-  bool wQueenMoved = true, bQueenMoved = true;
-
-  for (int sq = 0; sq < 64; sq++) {
-    int8_t p = b.sq[sq];
-    if (!p) continue;
-
-    int pt = abs_piece(p);
-    int sgn = (p > 0) ? +1 : -1;
-
-    // material
-    score += sgn * PV[pt];
-
-    // tracking
-    if (pt == PAWN) {
-      if (p > 0) wpawns_file[file_of(sq)]++;
-      else bpawns_file[file_of(sq)]++;
-    } else if (pt == BISHOP) {
-      if (p > 0) { if (!wB) wB = true; else wB2 = true; }
-      else { if (!bB) bB = true; else bB2 = true; }
-    } else if (pt == KING) {
-      if (p > 0) wKingSq = sq; else bKingSq = sq;
-    } else if (pt == QUEEN) {
-      if (p > 0 && sq == str_to_sq("d1")) wQueenMoved = false;
-      if (p < 0 && sq == str_to_sq("d8")) bQueenMoved = false;
-    }
+  int effective() const { return limit ? skill_from_elo(elo) : level; }
+};
 
-    // positional “barato”
-    if (pt == KNIGHT || pt == BISHOP) {
-      score += sgn * center_bonus(sq); // centralización
-    }
+// true si 'line' era una de las tres opciones (y actualiza 'so')
+static bool parse_strength_option(const string& line, StrengthOptions& so) {
+  auto tok = split_ws(line);
+  if (line.rfind("setoption name Skill Level value", 0) == 0)
+    so.level = clamp(atoi(tok.back().c_str()), 0, MAX_SKILL);
+  else if (line.rfind("setoption name UCI_LimitStrength value", 0) == 0)
+    so.limit = tok.back() == "true";
+  else if (line.rfind("setoption name UCI_Elo value", 0) == 0)
+    so.elo = clamp(atoi(tok.back().c_str()), MIN_ELO, MAX_ELO);
+  else
+    return false;
+  return true;
+}
 
-    if (pt == PAWN) {
-      int r = rank_of(sq);
-      int adv = (p > 0) ? r : (7 - r); // avance relativo
-      int bonus = adv * 4; // avance de peón
-      // peones centrales (d/e)
-      int f = file_of(sq);
-      if (f == 3 || f == 4) bonus += 8;
-      score += sgn * bonus;
-    }
-  }
+static StrengthOptions STRENGTH;   // UCI; en serve, una por sesión
 
-  // bishop pair
-  if (wB && wB2) score += 25;
-  if (bB && bB2) score -= 25;
+static void send_strength_options() {
+  uci_send("option name Skill Level type spin default " + to_string(MAX_SKILL) + " min 0 max " + to_string(MAX_SKILL));
+  uci_send("option name UCI_LimitStrength type check default false");
+  uci_send("option name UCI_Elo type spin default " + to_string(MAX_ELO) + " min " + to_string(MIN_ELO) +
+           " max " + to_string(MAX_ELO));
+}
 
-  // pawn structure: doubled + isolated (simple)
-  for (int f = 0; f < 8; f++) {
-    if (wpawns_file[f] >= 2) score -= 10 * (wpawns_file[f] - 1);
-    if (bpawns_file[f] >= 2) score += 10 * (bpawns_file[f] - 1);
+// Corta la búsqueda en curso (si hay) y espera su "bestmove".
+static void stop_search() {
+  if (!SEARCH_THREAD.joinable()) return;
+  SEARCH_CTL.stop.store(true);
+  SEARCH_THREAD.join();
+}
 
-    bool wIso = wpawns_file[f] > 0 &&
-                ( (f == 0 ? 0 : wpawns_file[f-1]) == 0 ) &&
-                ( (f == 7 ? 0 : wpawns_file[f+1]) == 0 );
-    bool bIso = bpawns_file[f] > 0 &&
-                ( (f == 0 ? 0 : bpawns_file[f-1]) == 0 ) &&
-                ( (f == 7 ? 0 : bpawns_file[f+1]) == 0 );
+// Jugada a ponderar: la mejor de la TT en la posición tras 'best'.
+static Move ponder_move_from_tt(Board& b, Move best) {
+  Undo u;
+  b.make_move(best, u);
+  TTHit hit;
+  Move pm = Move::none();
+  if (TT.probe(b.key, hit) && b.is_legal(hit.best)) pm = hit.best;
+  b.unmake_move(best, u);
+  return pm;
+}
 
-    if (wIso) score -= 8;
-    if (bIso) score += 8;
+// Libro: primero el binario (BookFile, por Board::key, toma transposiciones),
+// si no tiene la posición, el libro interno por secuencia de jugadas.
+static BinaryBook BOOK;
+static string BOOK_FILE;
+
+static Move book_move(const Board& board, const MoveList& legal, const vector<string>& move_history) {
+  if (BOOK.loaded()) {
+    // la de mayor peso; is_legal porque una colisión de key trae jugadas de otra posición
+    Move best = Move::none();
+    int bestWeight = -1;
+    for (const auto& e : BOOK.probe(board.key)) {
+      Move m = Move::from_raw(e.move);
+      if (e.weight > bestWeight && board.is_legal(m)) {
+        best = m;
+        bestWeight = e.weight;
+      }
+    }
+    if (!best.is_null()) return best;
   }
 
-  // king safety: bonus por enrocar; penalización si no enrocó “tarde”
-  auto castled = [&](Color c, int ksq)->bool {
-    if (c == WHITE) return ksq == str_to_sq("g1") || ksq == str_to_sq("c1");
-    return ksq == str_to_sq("g8") || ksq == str_to_sq("c8");
-  };
-
-  if (wKingSq != -1) {
-    if (castled(WHITE, wKingSq)) score += 18;
-    else if (b.fullmove >= 10) score -= 18;
-  }
-  if (bKingSq != -1) {
-    if (castled(BLACK, bKingSq)) score -= 18;
-    else if (b.fullmove >= 10) score += 18;
-  }
+  constexpr size_t BOOK_MAX_PLIES = 12;
+  if (move_history.size() > BOOK_MAX_PLIES) return Move::none();
 
-  // no salir con la dama demasiado temprano (suave)
-  if (b.fullmove <= 8) {
-    if (!wQueenMoved) score -= 8;
-    if (!bQueenMoved) score += 8;
-  }
+  vector<string> legal_uci;
+  legal_uci.reserve(legal.size());
+  for (const auto& m : legal) legal_uci.push_back(move_to_uci(m));
 
-  // perspectiva del que mueve (negamax)
-  return (b.side == WHITE) ? score : -score;
+  auto pick = opening_book_pick(move_history, legal_uci);
+  if (!pick) return Move::none();
+  auto it = find(legal_uci.begin(), legal_uci.end(), *pick);
+  if (it == legal_uci.end()) return Move::none();
+  return legal[(int)distance(legal_uci.begin(), it)];
 }
 
+// SyzygyPath: "<empty>" libera las tablas
+static void set_syzygy_path(string path) {
+  path.erase(0, path.find_first_not_of(' '));
+  int n = syzygy_init(path);
+  if (path.empty() || path == "<empty>") return;
+#if defined(USE_SYZYGY)
+  uci_send("info string syzygy " + path + " largest " + to_string(n));
+#else
+  (void)n;
+  uci_send("info string syzygy not available (build without BM_SYZYGY / Fathom)");
+#endif
+}
 
-// ---------------- TT ----------------
-static constexpr int MATE = 30000;
-static constexpr int INF  = 32000;
+// SearchCache: "<empty>" la cierra; SearchCacheMB solo cuenta al crear el archivo
+static int SEARCH_CACHE_MB = 64;
 
-static inline int score_to_tt(int s, int ply) {
-  if (s > MATE - 1000) return s + ply;
-  if (s < -MATE + 1000) return s - ply;
-  return s;
+static void set_search_cache(string path) {
+  path.erase(0, path.find_first_not_of(' '));
+  if (path.empty() || path == "<empty>") { search_cache_close(); return; }
+  string err;
+  if (search_cache_open(path, SEARCH_CACHE_MB, err)) uci_send("info string searchcache " + path);
+  else uci_send("info string searchcache " + path + " not opened: " + err);
 }
-static inline int score_from_tt(int s, int ply) {
-  if (s > MATE - 1000) return s - ply;
-  if (s < -MATE + 1000) return s + ply;
-  return s;
+
+static void set_eval_file(string path) {
+  path.erase(0, path.find_first_not_of(' '));
+  if (path.empty() || path == "<empty>") { nnue_unload(); return; }
+  string err;
+  if (nnue_load(path, err)) uci_send("info string nnue " + path + " kernel " + nnue_kernel_name());
+  else uci_send("info string nnue " + path + " not loaded: " + err);
 }
 
-enum TTFlag : uint8_t { TT_EXACT = 0, TT_ALPHA = 1, TT_BETA = 2 };
+// Límites de un "go" sobre 'ctl'. Se fijan antes de lanzar la búsqueda (no en
+// su thread) para que un "stop" o "ponderhit" inmediato no se pierda.
+static void prepare_go(SearchControl& ctl, const Board& board, const GoParams& gp, TimeBudget& ponderBudget) {
+  // go nodes: solo trabajo fijo (reproducible), salvo movetime explícito
+  TimeBudget tb;
+  if (gp.nodes) tb.hard_ms = gp.movetime_ms;
+  else if (gp.depth <= 0 && !gp.infinite) tb = choose_time_budget(board, gp);
+
+  ctl.reset();
+  ctl.node_limit.store(gp.nodes);
+  // nivel limitado: el presupuesto de nodos manda (movetime queda como tope)
+  if (uint64_t budget = skill_budget(ctl.skill).nodes)
+    ctl.node_limit.store(gp.nodes ? min(gp.nodes, budget) : budget);
+  if (gp.ponder) {
+    ponderBudget = tb;
+    ctl.ponder.store(true);
+  } else {
+    ctl.set_limits(tb);
+  }
+}
 
-struct TTEntry {
-  uint64_t key = 0;
-  int16_t depth = -1;
-  int16_t flag = TT_EXACT;
-  int32_t score = 0;
-  uint32_t best = 0; // encoded move
-};
+static int go_max_depth(const GoParams& gp, const SearchControl& ctl) {
+  int maxDepth = (gp.depth > 0 ? min(gp.depth, MAX_SEARCH_DEPTH)
+                               : (gp.infinite || gp.nodes ? MAX_SEARCH_DEPTH : 20));
+  if (ctl.skill < MAX_SKILL) maxDepth = min(maxDepth, skill_budget(ctl.skill).depth);
+  return maxDepth;
+}
 
-struct TranspositionTable {
-  vector<TTEntry> t;
-  size_t mask = 0;
-
-  void resize_mb(int mb) {
-    if (mb < 1) mb = 1;
-    size_t bytes = (size_t)mb * 1024ULL * 1024ULL;
-    size_t n = bytes / sizeof(TTEntry);
-    // power of two
-    size_t pow2 = 1;
-    while (pow2 < n) pow2 <<= 1;
-    t.assign(pow2, TTEntry{});
-    mask = pow2 - 1;
-  }
+// Jugada de libro para "go" (null si no hay o no conviene jugarla).
+// Con MultiPV (análisis / pistas) se quieren las líneas, no la jugada de libro.
+static Move go_book_move(Board& board, const MoveList& legal, const vector<string>& move_history,
+                         const GoParams& gp, const SearchControl& ctl) {
+  if (gp.infinite || ctl.multipv != 1) return Move::none();
+  Move book = book_move(board, legal, move_history);
+  if (!book.is_null() && !has_critical_tactics(board, legal) &&
+      !is_early_queen_move_uci(move_to_uci(book), move_history.size()) &&
+      move_keeps_king_safe(board, book))
+    return book;
+  return Move::none();
+}
 
-  TTEntry* probe(uint64_t k) {
-    if (t.empty()) return nullptr;
-    return &t[(size_t)k & mask];
-  }
-};
+// Cache persistente: con depth fijo hace falta al menos ese depth; con tiempo / nodos,
+// SEARCH_CACHE_MIN_DEPTH. Con nivel limitado no: daría la jugada de fuerza completa.
+static bool go_cache_probe(const Board& board, const GoParams& gp, const SearchControl& ctl, CachedResult& out) {
+  if (gp.infinite || ctl.multipv != 1 || ctl.skill < MAX_SKILL) return false;
+  int cacheDepth = gp.depth > 0 ? go_max_depth(gp, ctl) : SEARCH_CACHE_MIN_DEPTH;
+  return search_cache_probe(board, cacheDepth, out);
+}
 
-static TranspositionTable TT;
+// Cuerpo de "go": corre en su propio thread sobre copias del tablero y la historia,
+// así el loop UCI sigue atendiendo isready / stop / ponderhit mientras busca.
+static void search_go(Board board, vector<string> move_history, GoParams gp, SearchControl& ctl) {
+  const int maxDepth = go_max_depth(gp, ctl);
+  int score = 0;
 
-// ---------------- Search ----------------
-struct SearchState {
-  chrono::steady_clock::time_point stop;
-  bool use_time_limit = true;
-  uint64_t nodes = 0;
+  MoveList legal;
+  board.gen_legal(legal);
 
-  // killer moves: [ply][2]
-  array<array<uint32_t, 2>, 128> killers{};
-  // history: [color][from][to]
-  array<array<array<int, 64>, 64>, 2> history{};
+  // En go infinite / ponder UCI no permite "bestmove" antes de stop / ponderhit.
+  auto wait_release = [&]() {
+    uci_flush();   // que la última "info" no quede en el buffer mientras espera
+    while (!ctl.stop.load() && (gp.infinite || ctl.ponder.load()))
+      this_thread::sleep_for(chrono::milliseconds(1));
+  };
 
-  uint32_t tt_move = 0;
+  Move book = go_book_move(board, legal, move_history, gp, ctl);
+  if (!book.is_null()) {
+    string uci = move_to_uci(book);
+    ctl.send("info string bookhit move=" + uci);
+    wait_release();
+    ctl.send("bestmove " + uci);
+    return;
+  }
 
-  bool time_up() const {
-    return use_time_limit && chrono::steady_clock::now() >= stop;
+  CachedResult cached;
+  if (go_cache_probe(board, gp, ctl, cached)) {
+    string uci = move_to_uci(cached.best);
+    ctl.send("info depth " + to_string(cached.depth) + " multipv 1 score " + score_to_uci(cached.score) +
+             " nodes 0 nps 0 time 0 pv " + uci);
+    ctl.send("info string cachehit move=" + uci + " depth=" + to_string(cached.depth));
+    Move pm = ponder_move_from_tt(board, cached.best);
+    if (!pm.is_null()) uci += " ponder " + move_to_uci(pm);
+    wait_release();
+    ctl.send("bestmove " + uci);
+    return;
   }
-};
 
-static int mvv_lva(const Board& b, const Move& m) {
-  int8_t att = b.sq[m.from];
-  int8_t vic = b.sq[m.to];
-  if (m.flags & Move::ENPASSANT) vic = (int8_t)(b.side == WHITE ? -PAWN : PAWN);
-  int av = PV[abs_piece(att)];
-  int vv = PV[abs_piece(vic)];
-  return vv * 10 - av;
-}
+  int depthDone = 0;
+  Move bm = search_bestmove(board, ctl, maxDepth, score, nullptr, &depthDone);
 
-static int score_move(const Board& b, const Move& m, const SearchState& st, int ply, uint32_t ttBest) {
-  uint32_t em = encode_move(m);
-  if (ttBest && em == ttBest) return 1000000;
+  // Validate best move exists; if none, 0000
+  string out = legal.empty() ? "0000" : move_to_uci(legal[0]); // fallback legal
+  bool matched = false;
 
-  if (m.flags & Move::CAPTURE) return 500000 + mvv_lva(b, m);
+  for (auto &m : legal) {
+    if (m == bm) {
+      out = move_to_uci(m);
+      matched = true;
+      break;
+    }
+  }
 
-  // killers
-  if (st.killers[ply][0] == em) return 490000;
-  if (st.killers[ply][1] == em) return 480000;
+  // Si no matcheó pero había legales, NO es terminal. Solo fue “bestmove inválido”.
+  if (!matched && !legal.empty()) {
+    ctl.send("info string fallback_bestmove_used");
+  }
 
-  // history
-  return st.history[b.side][m.from][m.to];
-}
+  if (matched) {
+    if (ctl.multipv == 1 && ctl.skill >= MAX_SKILL) search_cache_store(board, {bm, score, depthDone, TT_EXACT});
+    Move pm = ponder_move_from_tt(board, bm);
+    if (!pm.is_null()) out += " ponder " + move_to_uci(pm);
+  }
 
-static void order_moves(const Board& b, vector<Move>& moves, const SearchState& st, int ply, uint32_t ttBest) {
-  stable_sort(moves.begin(), moves.end(), [&](const Move& a, const Move& c) {
-    return score_move(b, a, st, ply, ttBest) > score_move(b, c, st, ply, ttBest);
-  });
+  wait_release();
+  ctl.send("bestmove " + out);
 }
 
-static int qsearch(Board& b, int alpha, int beta, SearchState& st, int ply) {
-  if (st.time_up()) return eval(b);
-  st.nodes++;
+// ---------------- Book builder ----------------
+// buildbook: PGN -> libro binario. Un thread lee el PGN en streaming y arma
+// lotes de partidas; los workers parsean SAN con el propio Board y acumulan
+// W/D/L por (posición, jugada) en su propio mapa; al final se mezclan.
+struct BookBuildOptions {
+  int min_elo = 2200;
+  int min_games = 5;
+  int max_ply = 30;
+  int threads = 0;        // 0 => hardware_concurrency
+};
 
-  int stand = eval(b);
-  if (stand >= beta) return beta;
-  if (stand > alpha) alpha = stand;
+struct PgnGame {
+  int white_elo = 0, black_elo = 0;
+  string result;
+  string fen;             // tag FEN (partidas desde posición)
+  string movetext;
+};
 
-  vector<Move> moves;
-  b.gen_legal(moves);
+// Igual que MoveStats de generate_book_from_pgn.py, desde el bando que juega
+struct BookMoveStats {
+  uint16_t move = 0;
+  uint32_t wins = 0, draws = 0, losses = 0;
+
+  uint32_t count() const { return wins + draws + losses; }
+  double score() const { return count() ? (wins + 0.5 * draws) / count() : 0.5; }
+  // popularidad (escala log) promediada con rendimiento, 0..100
+  int weight() const {
+    int popularity = min(100, (int)(20 * log((double)count() + 1)));
+    int performance = (int)(score() * 100);
+    return max(1, min(100, (popularity + performance) / 2));
+  }
+};
 
-  // Only captures (and promotions via capture already included)
-  vector<Move> caps;
-  caps.reserve(moves.size());
-  for (auto &m : moves) if (m.flags & Move::CAPTURE) caps.push_back(m);
+using BookStatsMap = unordered_map<uint64_t, vector<BookMoveStats>>;
 
-  order_moves(b, caps, st, ply, 0);
+static void book_record(BookStatsMap& map, uint64_t key, Move m, int outcome) {
+  auto& moves = map[key];
+  auto it = find_if(moves.begin(), moves.end(), [&](const BookMoveStats& s) { return s.move == m.data; });
+  if (it == moves.end()) { moves.push_back({}); it = moves.end() - 1; it->move = m.data; }
+  if (outcome > 0) it->wins++;
+  else if (outcome == 0) it->draws++;
+  else it->losses++;
+}
 
-  for (auto &m : caps) {
-    if (st.time_up()) break;
+// Recorre la línea principal (sin comentarios, variantes ni NAGs) hasta max_ply
+static bool book_add_game(BookStatsMap& map, const PgnGame& g, const BookBuildOptions& opt) {
+  int white = (g.result == "1-0") ? 1 : (g.result == "0-1") ? -1 : (g.result == "1/2-1/2") ? 0 : 2;
+  if (white == 2) return false;
+  if (g.white_elo < opt.min_elo || g.black_elo < opt.min_elo) return false;
+
+  Board b;
+  if (g.fen.empty()) b.set_startpos();
+  else if (!b.set_fen(g.fen)) return false;
+
+  const string& t = g.movetext;
+  size_t i = 0;
+  int ply = 0, variation = 0;
+  while (i < t.size() && ply < opt.max_ply) {
+    char c = t[i];
+    if (c == '{') { size_t e = t.find('}', i); i = (e == string::npos) ? t.size() : e + 1; continue; }
+    if (c == ';') { size_t e = t.find('\n', i); i = (e == string::npos) ? t.size() : e + 1; continue; }
+    if (c == '(') { variation++; i++; continue; }
+    if (c == ')') { variation = max(0, variation - 1); i++; continue; }
+    if (isspace((unsigned char)c)) { i++; continue; }
+
+    size_t e = i;
+    while (e < t.size() && !isspace((unsigned char)t[e]) && !strchr("{}();", t[e])) e++;
+    string tok = t.substr(i, e - i);
+    i = e;
+    if (variation > 0 || tok[0] == '$') continue;
+
+    // "12." / "12..." / "12.e4"
+    size_t d = 0;
+    while (d < tok.size() && (isdigit((unsigned char)tok[d]) || tok[d] == '.')) d++;
+    if (d > 0 && d < tok.size() && tok[d - 1] == '.') tok.erase(0, d);
+    else if (d == tok.size()) continue;
+    if (tok == "1-0" || tok == "0-1" || tok == "1/2-1/2" || tok == "*") break;
+
+    Move m = parse_san(b, tok);
+    if (m.is_null()) break;   // SAN inválida: usar lo leído hasta acá
+    int outcome = (b.side == WHITE) ? white : -white;
+    book_record(map, b.key, m, outcome);
     Undo u;
     b.make_move(m, u);
-    int score = -qsearch(b, -beta, -alpha, st, ply + 1);
-    b.unmake_move(m, u);
-
-    if (score >= beta) return beta;
-    if (score > alpha) alpha = score;
+    ply++;
   }
-  return alpha;
+  return true;
 }
 
-static int negamax(Board& b, int depth, int alpha, int beta, SearchState& st, int ply, uint32_t& outBest) {
-  if (st.time_up()) return eval(b);
-  st.nodes++;
-
-  if (b.halfmove >= 100) return 0;         // 50-move draw
-  if (b.is_repetition()) return 0;
+static int build_book(const string& pgnPath, const string& outPath, const BookBuildOptions& opt) {
+  ifstream in(pgnPath);
+  if (!in) { cerr << "buildbook: cannot open " << pgnPath << "\n"; return 1; }
+
+  int nthreads = opt.threads > 0 ? opt.threads : (int)max(1u, thread::hardware_concurrency());
+  constexpr size_t BATCH = 512;
+  constexpr size_t MAX_QUEUED = 64;   // lotes en espera: acota memoria con PGNs enormes
+
+  mutex mtx;
+  condition_variable cv_work, cv_space;
+  vector<vector<PgnGame>> queue;
+  bool done = false;
+  vector<BookStatsMap> maps(nthreads);
+  atomic<uint64_t> used{0};
+
+  vector<thread> workers;
+  for (int w = 0; w < nthreads; w++) {
+    workers.emplace_back([&, w]() {
+      for (;;) {
+        vector<PgnGame> batch;
+        {
+          unique_lock<mutex> lk(mtx);
+          cv_work.wait(lk, [&]() { return done || !queue.empty(); });
+          if (queue.empty()) return;
+          batch = move(queue.back());
+          queue.pop_back();
+        }
+        cv_space.notify_one();
+        for (const auto& g : batch)
+          if (book_add_game(maps[w], g, opt)) used.fetch_add(1, memory_order_relaxed);
+      }
+    });
+  }
 
-  bool inCheck = b.in_check(b.side);
+  uint64_t total = 0;
+  vector<PgnGame> batch;
+  auto push_batch = [&]() {
+    if (batch.empty()) return;
+    {
+      unique_lock<mutex> lk(mtx);
+      cv_space.wait(lk, [&]() { return queue.size() < MAX_QUEUED; });
+      queue.push_back(move(batch));
+    }
+    batch.clear();
+    cv_work.notify_one();
+  };
 
-  if (depth <= 0) return qsearch(b, alpha, beta, st, ply);
+  PgnGame g;
+  bool inMoves = false;
+  auto finish_game = [&]() {
+    if (inMoves) {
+      batch.push_back(move(g));
+      total++;
+      if (batch.size() >= BATCH) push_batch();
+    }
+    g = PgnGame{};
+    inMoves = false;
+  };
 
-  // TT probe
-  uint32_t ttBest = 0;
-  if (auto e = TT.probe(b.key)) {
-    if (e->key == b.key && e->depth >= depth) {
-      int ttScore = score_from_tt(e->score, ply);
-      ttBest = e->best;
-      if (e->flag == TT_EXACT) return ttScore;
-      if (e->flag == TT_ALPHA && ttScore <= alpha) return ttScore;
-      if (e->flag == TT_BETA  && ttScore >= beta)  return ttScore;
-    } else if (e->key == b.key) {
-      ttBest = e->best;
+  string line;
+  while (getline(in, line)) {
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    if (!line.empty() && line[0] == '[') {
+      if (inMoves) finish_game();
+      size_t sp = line.find(' '), q1 = line.find('"'), q2 = line.rfind('"');
+      if (sp == string::npos || q1 == string::npos || q2 <= q1) continue;
+      string tag = line.substr(1, sp - 1), val = line.substr(q1 + 1, q2 - q1 - 1);
+      if (tag == "WhiteElo") g.white_elo = atoi(val.c_str());
+      else if (tag == "BlackElo") g.black_elo = atoi(val.c_str());
+      else if (tag == "Result") g.result = val;
+      else if (tag == "FEN") g.fen = val;
+      continue;
+    }
+    if (line.find_first_not_of(" \t") == string::npos) continue;
+    inMoves = true;
+    g.movetext += line;
+    g.movetext += '\n';
+  }
+  finish_game();
+  push_batch();
+  {
+    lock_guard<mutex> lk(mtx);
+    done = true;
+  }
+  cv_work.notify_all();
+  for (auto& t : workers) t.join();
+
+  // mezclar los mapas de cada thread
+  BookStatsMap& all = maps[0];
+  for (int w = 1; w < nthreads; w++) {
+    for (auto& [key, moves] : maps[w]) {
+      auto& dst = all[key];
+      for (const auto& s : moves) {
+        auto it = find_if(dst.begin(), dst.end(), [&](const BookMoveStats& d) { return d.move == s.move; });
+        if (it == dst.end()) dst.push_back(s);
+        else { it->wins += s.wins; it->draws += s.draws; it->losses += s.losses; }
+      }
     }
+    BookStatsMap().swap(maps[w]);
   }
 
-  vector<Move> moves;
-  b.gen_legal(moves);
+  // por posición: jugadas con min_games, mejores 5 por (score, partidas)
+  constexpr size_t MAX_MOVES_PER_POSITION = 5;
+  vector<BinaryBookEntry> entries;
+  size_t positions = 0;
+  for (auto& [key, moves] : all) {
+    vector<BookMoveStats> good;
+    for (const auto& s : moves) if ((int)s.count() >= opt.min_games) good.push_back(s);
+    if (good.empty()) continue;
+    sort(good.begin(), good.end(), [](const BookMoveStats& a, const BookMoveStats& b) {
+      if (a.score() != b.score()) return a.score() > b.score();
+      if (a.count() != b.count()) return a.count() > b.count();
+      return a.move < b.move;
+    });
+    if (good.size() > MAX_MOVES_PER_POSITION) good.resize(MAX_MOVES_PER_POSITION);
+    positions++;
+    for (const auto& s : good)
+      entries.push_back({key, s.move, (uint16_t)s.weight(), s.count()});
+  }
 
-  if (moves.empty()) {
-    if (inCheck) return -MATE + ply;
-    return 0; // stalemate
+  if (!BinaryBook::write(outPath, move(entries))) {
+    cerr << "buildbook: cannot write " << outPath << "\n";
+    return 1;
   }
+  cout << "buildbook: games " << total << " used " << used.load() << " positions " << positions
+       << " -> " << outPath << "\n";
+  return 0;
+}
 
-  order_moves(b, moves, st, ply, ttBest);
+// ---------------- Bench ----------------
+// bench [depth] [threads] [hash]: búsqueda a profundidad fija sobre un set fijo
+// (apertura / medio juego / final / táctica). Con 1 thread el total de nodos es
+// determinista y sirve de firma funcional; el NPS sirve para comparar builds.
+static constexpr int BENCH_DEFAULT_DEPTH = 11;
 
-  int bestScore = -INF;
-  uint32_t bestMoveEnc = 0;
+struct BenchResult {
+  uint64_t nodes = 0;
+  double ms = 0;
+  uint64_t nps() const { return (uint64_t)(ms > 0 ? nodes * 1000.0 / ms : 0); }
+};
 
-  int origAlpha = alpha;
+static bool bench_pass(int depth, int hashMb, bool verbose, BenchResult& out) {
+  TT.resize_mb(hashMb);   // también limpia: cada bench arranca igual
+
+  SearchControl ctl;
+  ctl.reset();
+  ctl.quiet = true;
+
+  const int n = (int)BENCH_FENS.size();
+  out = {};
+  auto t0 = chrono::steady_clock::now();
+  for (int i = 0; i < n; i++) {
+    Board b;
+    if (!b.set_fen(BENCH_FENS[i])) { cerr << "bench: bad fen " << BENCH_FENS[i] << "\n"; return false; }
+    // sin jugadas (mate / ahogado) no busca nada y no aporta a la firma
+    MoveList legal;
+    b.gen_legal(legal);
+    if (legal.empty()) { cerr << "bench: no legal moves in " << BENCH_FENS[i] << "\n"; return false; }
+    int score = 0;
+    uint64_t nodes = 0;
+    Move bm = search_bestmove(b, ctl, depth, score, &nodes);
+    out.nodes += nodes;
+    if (verbose)
+      cerr << "Position " << (i + 1) << "/" << n << " " << (bm.is_null() ? "0000" : move_to_uci(bm))
+           << " nodes " << nodes << "\n";
+  }
+  out.ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+  return true;
+}
+
+static int run_bench(int depth, int threads, int hashMb) {
+  SEARCH_THREADS = max(1, min(32, threads));
+  BenchResult r;
+  if (!bench_pass(depth, hashMb, true, r)) return 1;
 
-  for (auto &m : moves) {
-    if (st.time_up()) break;
+  cout << "===========================\n"
+       << "Total time (ms) : " << (uint64_t)r.ms << "\n"
+       << "Nodes searched  : " << r.nodes << "\n"
+       << "Nodes/second    : " << r.nps() << "\n";
+  return 0;
+}
 
+// Partida NNUE vs clásica a movetime fijo desde 'fen' (cada bando con su TT).
+// Resultado desde el lado de la NNUE: 1 gana, 0 tablas, -1 pierde.
+static constexpr int MATCH_MAX_PLIES = 300;   // tope: tablas
+
+static int play_match_game(const string& fen, Color nnueSide, int movetimeMs, TranspositionTable* tts[2]) {
+  Board b;
+  if (!b.set_fen(fen)) return 0;
+  SearchControl ctl;
+  ctl.quiet = true;
+  ctl.threads = 1;
+
+  for (int ply = 0; ply < MATCH_MAX_PLIES; ply++) {
+    MoveList legal;
+    b.gen_legal(legal);
+    if (legal.empty()) return b.in_check(b.side) ? (b.side == nnueSide ? -1 : 1) : 0;
+    if (b.halfmove >= 100 || b.is_repetition()) return 0;
+
+    bool nnueMoves = (b.side == nnueSide);
+    NNUE_ON = nnueMoves;
+    ctl.tt = tts[nnueMoves];
+    ctl.reset();
+    ctl.set_movetime(movetimeMs);
+    int score = 0;
+    Move m = search_bestmove(b, ctl, MAX_SEARCH_DEPTH, score);
+    if (!legal.contains(m)) m = legal[0];
     Undo u;
     b.make_move(m, u);
+  }
+  return 0;
+}
+
+// bench nnue <file> [depth] [movetime_ms] [games]: costo en NPS (mismo bench a
+// profundidad fija, clásica vs NNUE) y ganancia de fuerza al mismo tiempo por
+// jugada (mini match NNUE vs clásica desde las posiciones del bench, cada una
+// con los dos colores). 1 thread.
+static int run_bench_nnue(const string& file, int depth, int movetimeMs, int games) {
+  string err;
+  if (!nnue_load(file, err)) { cerr << "bench: nnue " << file << ": " << err << "\n"; return 1; }
+  SEARCH_THREADS = 1;
+
+  BenchResult classic, nnue;
+  NNUE_ON = false;
+  if (!bench_pass(depth, 16, false, classic)) return 1;
+  NNUE_ON = true;
+  if (!bench_pass(depth, 16, false, nnue)) return 1;
+
+  cout << "===========================\n"
+       << "Kernel          : " << nnue_kernel_name() << "\n"
+       << "Classic         : " << classic.nodes << " nodes, " << classic.nps() << " nps\n"
+       << "NNUE            : " << nnue.nodes << " nodes, " << nnue.nps() << " nps ("
+       << fixed << setprecision(1) << (classic.nps() ? 100.0 * nnue.nps() / classic.nps() : 0.0)
+       << "% of classic)\n";
+
+  if (games <= 0) return 0;
+  TranspositionTable ttClassic, ttNnue;
+  ttClassic.resize_mb(16);
+  ttNnue.resize_mb(16);
+  TranspositionTable* tts[2] = {&ttClassic, &ttNnue};
+
+  int w = 0, d = 0, l = 0;
+  for (int g = 0; g < games; g++) {
+    ttClassic.clear();
+    ttNnue.clear();
+    const string& fen = BENCH_FENS[(g / 2) % BENCH_FENS.size()];
+    int r = play_match_game(fen, (g % 2) ? BLACK : WHITE, movetimeMs, tts);
+    (r > 0 ? w : r < 0 ? l : d)++;
+    cerr << "Game " << (g + 1) << "/" << games << " " << (r > 0 ? "nnue" : r < 0 ? "classic" : "draw") << "\n";
+  }
+  double score = (w + 0.5 * d) / games;
+  double elo = (score > 0 && score < 1) ? -400.0 * log10(1.0 / score - 1.0) : (score >= 1 ? 999.0 : -999.0);
+  cout << "Match (" << movetimeMs << " ms/move): NNUE +" << w << " =" << d << " -" << l
+       << "  score " << setprecision(1) << 100.0 * score << "%  elo " << showpos << setprecision(0) << elo
+       << noshowpos << "\n";
+  return 0;
+}
 
-    uint32_t childBest = 0;
-    int score = -negamax(b, depth - 1, -beta, -alpha, st, ply + 1, childBest);
+// ---------------- Server mode ----------------
+// serve [--sessions N] [--threads M]: muchas partidas en un solo proceso.
+// Cada línea "session <id> <comando>" va a la sesión <id> (se crea al primer
+// uso; comandos: position, go, stop, ponderhit, ucinewgame, isready, close,
+// setoption name MultiPV / Skill Level / UCI_LimitStrength / UCI_Elo) y todo lo que responde sale con el mismo prefijo.
+// N workers buscan en paralelo (los demás "go" esperan en cola, con el reloj
+// ya corriendo), cada búsqueda con M threads; todas las sesiones comparten la TT.
+struct ServeSession {
+  Board board;
+  string base;                  // ver uci_position
+  vector<string> history;
+  SearchControl ctl;
+  TimeBudget ponder_budget;
+  StrengthOptions strength;
+  bool busy = false;            // go en cola o buscando (bajo SERVE_MUTEX)
+  condition_variable idle;
+};
 
-    b.unmake_move(m, u);
+struct ServeJob {
+  ServeSession* s;
+  Board board;
+  vector<string> history;
+  GoParams gp;
+};
 
-    if (score > bestScore) {
-      bestScore = score;
-      bestMoveEnc = encode_move(m);
+static mutex SERVE_MUTEX;
+static condition_variable SERVE_JOBS_CV;
+static deque<ServeJob> SERVE_JOBS;
+static bool SERVE_QUIT = false;
+
+static void serve_worker() {
+  for (;;) {
+    ServeJob job;
+    {
+      unique_lock<mutex> lock(SERVE_MUTEX);
+      SERVE_JOBS_CV.wait(lock, [] { return SERVE_QUIT || !SERVE_JOBS.empty(); });
+      if (SERVE_JOBS.empty()) return;
+      job = move(SERVE_JOBS.front());
+      SERVE_JOBS.pop_front();
     }
-    if (score > alpha) alpha = score;
-    if (alpha >= beta) {
-      // beta cutoff: update killers/history for quiet moves
-      uint32_t em = encode_move(m);
-      if (!(m.flags & Move::CAPTURE)) {
-        if (st.killers[ply][0] != em) {
-          st.killers[ply][1] = st.killers[ply][0];
-          st.killers[ply][0] = em;
+    search_go(move(job.board), move(job.history), job.gp, job.s->ctl);
+    lock_guard<mutex> lock(SERVE_MUTEX);
+    job.s->busy = false;
+    job.s->idle.notify_all();
+  }
+}
+
+// "bestmove" de un go que nunca empezó: libro, cache o la primera legal, sin
+// buscar (corre en el thread que lee stdin, no puede frenar a las demás sesiones).
+static void serve_reply_unsearched(ServeJob& job) {
+  const SearchControl& ctl = job.s->ctl;
+  MoveList legal;
+  job.board.gen_legal(legal);
+  string out = legal.empty() ? "0000" : move_to_uci(legal[0]);
+  CachedResult cached;
+  Move book = go_book_move(job.board, legal, job.history, job.gp, ctl);
+  if (!book.is_null()) out = move_to_uci(book);
+  else if (go_cache_probe(job.board, job.gp, ctl, cached)) out = move_to_uci(cached.best);
+  ctl.send("bestmove " + out);
+}
+
+// Corta la búsqueda de la sesión y espera su "bestmove". Si todavía está en
+// cola se contesta acá mismo sin buscar: esperar a un worker libre podría no
+// terminar nunca si todos están en "go infinite".
+static void serve_stop(ServeSession& s) {
+  unique_lock<mutex> lock(SERVE_MUTEX);
+  if (!s.busy) return;
+  s.ctl.stop.store(true);
+  auto it = find_if(SERVE_JOBS.begin(), SERVE_JOBS.end(), [&](const ServeJob& j) { return j.s == &s; });
+  if (it != SERVE_JOBS.end()) {
+    ServeJob job = move(*it);
+    SERVE_JOBS.erase(it);
+    s.busy = false;
+    lock.unlock();
+    serve_reply_unsearched(job);
+    return;
+  }
+  s.idle.wait(lock, [&] { return !s.busy; });
+}
+
+static int run_serve(int workers, int threads) {
+  workers = max(1, min(256, workers));
+  threads = max(1, min(32, threads));
+
+  unordered_map<string, unique_ptr<ServeSession>> sessions;
+  vector<thread> pool;
+  for (int i = 0; i < workers; i++) pool.emplace_back(serve_worker);
+
+  auto stop_all = [&]() {
+    for (auto& [id, s] : sessions) serve_stop(*s);
+  };
+
+  string line;
+  while (getline(cin, line)) {
+    auto tok = split_ws(line);
+    if (tok.empty()) continue;
+
+    // Un comando mal formado (p. ej. "go depth x") no tira abajo al resto de
+    // las sesiones: se responde con error y se sigue leyendo.
+    try {
+      if (tok[0] == "session" && tok.size() >= 3) {
+        const string& id = tok[1];
+        const string& cmd = tok[2];
+        // resto de la línea: el comando UCI tal cual
+        string rest = line.substr(line.find(cmd, line.find(id) + id.size()));
+
+        auto it = sessions.find(id);
+        if (it == sessions.end()) {
+          if (cmd == "close") continue;
+          auto s = make_unique<ServeSession>();
+          s->board.set_startpos();
+          s->ctl.threads = threads;
+          s->ctl.tag = "session " + id + " ";
+          it = sessions.emplace(id, move(s)).first;
+        }
+        ServeSession& s = *it->second;
+
+        if (cmd == "position") {
+          serve_stop(s);
+          uci_position(s.board, rest, s.base, s.history);
+        } else if (cmd == "go") {
+          serve_stop(s);
+          GoParams gp = parse_go(rest);
+          prepare_go(s.ctl, s.board, gp, s.ponder_budget);
+          lock_guard<mutex> lock(SERVE_MUTEX);
+          s.busy = true;
+          SERVE_JOBS.push_back({&s, s.board, s.history, gp});
+          SERVE_JOBS_CV.notify_one();
+        } else if (cmd == "stop") {
+          serve_stop(s);
+        } else if (cmd == "ponderhit") {
+          s.ctl.set_limits(s.ponder_budget);
+          s.ctl.ponder.store(false);
+        } else if (cmd == "ucinewgame") {
+          serve_stop(s);
+          s.board.set_startpos();
+          s.base.clear();
+          s.history.clear();
+        } else if (cmd == "isready") {
+          s.ctl.send("readyok");
+        } else if (rest.rfind("setoption name MultiPV value", 0) == 0) {
+          serve_stop(s);
+          s.ctl.multipv = parse_multipv(rest);
+        } else if (parse_strength_option(rest, s.strength)) {
+          serve_stop(s);
+          s.ctl.skill = s.strength.effective();
+        } else if (cmd == "close") {
+          serve_stop(s);
+          sessions.erase(it);
         }
-        st.history[b.side][m.from][m.to] += depth * depth;
       }
-      break;
+      else if (line == "uci") {
+        uci_send("id name BM-Engine");
+        uci_send("id author Benja");
+        uci_send("option name Hash type spin default 64 min 1 max 2048");
+        uci_send("option name EvalFile type string default <empty>");
+        uci_send("option name SyzygyPath type string default <empty>");
+        uci_send("option name MultiPV type spin default 1 min 1 max " + to_string(MAX_MULTI_PV));
+        send_strength_options();
+        uci_send("option name SearchCache type string default <empty>");
+        uci_send("option name SearchCacheMB type spin default 64 min 1 max 4096");
+        uci_send("option name SearchCacheDepth type spin default 12 min 1 max " + to_string(MAX_SEARCH_DEPTH));
+        uci_send("uciok");
+      }
+      else if (line == "isready") {
+        uci_send("readyok");
+      }
+      else if (line.rfind("setoption name Hash value", 0) == 0) {
+        stop_all();
+        TT.resize_mb(stoi(tok.back()));
+      }
+      else if (line.rfind("setoption name SyzygyPath value", 0) == 0) {
+        stop_all();
+        set_syzygy_path(line.substr(string("setoption name SyzygyPath value").size()));
+      }
+      else if (line.rfind("setoption name EvalFile value", 0) == 0) {
+        stop_all();
+        set_eval_file(line.substr(string("setoption name EvalFile value").size()));
+      }
+      else if (line.rfind("setoption name SearchCacheMB value", 0) == 0) {
+        SEARCH_CACHE_MB = clamp(atoi(tok.back().c_str()), 1, 4096);
+      }
+      else if (line.rfind("setoption name SearchCacheDepth value", 0) == 0) {
+        SEARCH_CACHE_MIN_DEPTH = clamp(atoi(tok.back().c_str()), 1, MAX_SEARCH_DEPTH);
+      }
+      else if (line.rfind("setoption name SearchCache value", 0) == 0) {
+        stop_all();
+        set_search_cache(line.substr(string("setoption name SearchCache value").size()));
+      }
+      else if (line == "quit") {
+        break;
+      }
+    } catch (const exception& e) {
+      string tag = (tok[0] == "session" && tok.size() >= 3) ? "session " + tok[1] + " " : "";
+      uci_send(tag + "info string error " + e.what());
     }
   }
 
-  outBest = bestMoveEnc;
+  stop_all();
+  {
+    lock_guard<mutex> lock(SERVE_MUTEX);
+    SERVE_QUIT = true;
+  }
+  SERVE_JOBS_CV.notify_all();
+  for (auto& t : pool) t.join();
+  uci_flush();
+  return 0;
+}
 
-  // Store TT
-  if (auto e = TT.probe(b.key)) {
-    TTFlag flag = TT_EXACT;
-    if (bestScore <= origAlpha) flag = TT_ALPHA;
-    else if (bestScore >= beta) flag = TT_BETA;
+// ---------------- Batch analysis ----------------
+// analyze [--input FILE|-] (--depth D | --nodes N) [--jobs J] [--format jsonl|csv]
+//         [--hash MB] [--shared-tt]
+// Una posición por línea (FEN o EPD; del EPD se toma el opcode id). Un thread
+// lee en streaming hacia una cola acotada y J workers buscan con 1 thread cada
+// uno, así la memoria no depende del tamaño de la entrada. Los resultados salen
+// a medida que terminan (no en orden: "n" es la línea de entrada). Cada worker
+// usa su propia TT de --hash MB salvo --shared-tt (una sola, la global).
+// Mate: "score_mate" en jugadas (como UCI) en lugar de "score_cp".
+struct AnalyzeOptions {
+  string input = "-";
+  int depth = 0;
+  uint64_t nodes = 0;
+  int jobs = 1;
+  bool csv = false;
+  int hash_mb = 16;
+  bool shared_tt = false;
+};
+
+struct AnalyzeItem {
+  uint64_t n = 0;     // línea de entrada (1-based)
+  string fen;
+  string id;
+};
 
-    e->key = b.key;
-    e->depth = (int16_t)depth;
-    e->flag = (int16_t)flag;
-    e->score = score_to_tt(bestScore, ply);
-    e->best = bestMoveEnc;
+// FEN completo o EPD ("<4 campos> [opcodes;]"): a FEN de 6 campos + id del EPD.
+static bool parse_epd_line(const string& line, string& fen, string& id) {
+  auto tok = split_ws(line);
+  if (tok.size() < 4) return false;
+  fen = tok[0] + " " + tok[1] + " " + tok[2] + " " + tok[3];
+  bool counters = tok.size() >= 6 && all_of(tok[4].begin(), tok[4].end(), ::isdigit)
+                                  && all_of(tok[5].begin(), tok[5].end(), ::isdigit);
+  fen += counters ? " " + tok[4] + " " + tok[5] : " 0 1";
+
+  id.clear();
+  size_t p = line.find(" id ");
+  if (p != string::npos) {
+    size_t q1 = line.find('"', p);
+    size_t q2 = q1 == string::npos ? q1 : line.find('"', q1 + 1);
+    if (q2 != string::npos) id = line.substr(q1 + 1, q2 - q1 - 1);
   }
+  return true;
+}
 
-  return bestScore;
+static string json_escape(const string& s) {
+  string o;
+  for (char c : s) {
+    if (c == '"' || c == '\\') o += '\\';
+    if ((unsigned char)c < 0x20) continue;
+    o += c;
+  }
+  return o;
+}
+
+static string csv_quote(const string& s) {
+  if (s.find_first_of(",\"") == string::npos) return s;
+  string o = "\"";
+  for (char c : s) { if (c == '"') o += '"'; o += c; }
+  return o + "\"";
 }
 
+static int run_analyze(const AnalyzeOptions& opt) {
+  if (opt.depth <= 0 && opt.nodes == 0) { cerr << "analyze: --depth or --nodes required\n"; return 1; }
+  const int jobs = max(1, min(256, opt.jobs));
 
-static Move search_bestmove(Board& b, int movetime_ms, int maxDepth, int& outScoreCp) {
-  SearchState st;
-  auto start = chrono::steady_clock::now();
-  st.use_time_limit = movetime_ms > 0;
-  st.stop = st.use_time_limit ? (start + chrono::milliseconds(movetime_ms)) : chrono::steady_clock::time_point::max();
-  st.nodes = 0;
-  Move best{};
-  uint32_t bestEnc = 0;
-  int bestScore = -INF;
-
-  int prev = 0;                 // score del depth anterior para aspiration
-  const int WINDOW = 80;      // centipawns (50-80 suele ir bien)
-
-  vector<Move> root;
-  b.gen_legal(root);
-  if (root.empty()) {
-    outScoreCp = 0;
-    return Move{}; // terminal real
+  ifstream file;
+  if (opt.input != "-") {
+    file.open(opt.input);
+    if (!file) { cerr << "analyze: cannot open " << opt.input << "\n"; return 1; }
   }
+  istream& in = (opt.input == "-") ? cin : file;
 
-  // fallback: siempre una jugada legal
-  best = root[0];
-  bestEnc = encode_move(best);
-  bestScore = 0;
+  if (opt.shared_tt) TT.resize_mb(opt.hash_mb);
 
-  for (int depth = 1; depth <= maxDepth; depth++) {
-    if (st.time_up()) break;
+  // cola acotada: el lector espera si los workers van atrás
+  const size_t QUEUE_CAP = (size_t)jobs * 64;
+  mutex qm;
+  condition_variable notEmpty, notFull;
+  deque<AnalyzeItem> queue;
+  bool eof = false;
 
-    int alpha = -INF, beta = INF;
-    if (depth >= 2) {
-      alpha = prev - WINDOW;
-      beta  = prev + WINDOW;
+  mutex outm;
+  atomic<uint64_t> done{0}, totalNodes{0};
+
+  if (opt.csv) cout << "n,fen,id,bestmove,score_cp,score_mate,nodes,time_ms\n";
+
+  auto worker = [&]() {
+    unique_ptr<TranspositionTable> ownTT;
+    if (!opt.shared_tt) {
+      ownTT = make_unique<TranspositionTable>();
+      ownTT->resize_mb(opt.hash_mb);
     }
-    uint32_t pv = bestEnc;  // fallback: si corta por tiempo, no perdés PV
-    int score = negamax(b, depth, alpha, beta, st, 0, pv);
-
-    // si falla la ventana y aún hay tiempo, re-search con ventana completa
-    if (!st.time_up() && depth >= 2) {
-      if (score <= alpha || score >= beta) {
-      pv = bestEnc;           // mismo motivo: no borres el PV
-      score = negamax(b, depth, -INF, INF, st, 0, pv);
+    SearchControl ctl;
+    ctl.quiet = true;
+    ctl.threads = 1;
+    ctl.tt = ownTT.get();
+    const int maxDepth = opt.depth > 0 ? min(opt.depth, MAX_SEARCH_DEPTH) : MAX_SEARCH_DEPTH;
+
+    for (;;) {
+      AnalyzeItem item;
+      {
+        unique_lock<mutex> lock(qm);
+        notEmpty.wait(lock, [&] { return eof || !queue.empty(); });
+        if (queue.empty()) return;
+        item = move(queue.front());
+        queue.pop_front();
       }
-    }
+      notFull.notify_one();
 
-    if (st.time_up()) break;
+      Board b;
+      if (!b.set_fen(item.fen)) {
+        lock_guard<mutex> lock(outm);
+        cerr << "analyze: line " << item.n << ": bad fen\n";
+        continue;
+      }
+      ctl.reset();
+      ctl.node_limit.store(opt.nodes);
+
+      auto t0 = chrono::steady_clock::now();
+      int score = 0;
+      uint64_t nodes = 0;
+      Move bm = search_bestmove(b, ctl, maxDepth, score, &nodes);
+      auto ms = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - t0).count();
+      string uci = bm.is_null() ? "0000" : move_to_uci(bm);
+
+      // Mate: score_mate en jugadas (como "score mate" de UCI) en vez de score_cp
+      const bool mate = is_mate_score(score);
+      ostringstream o;
+      if (opt.csv) {
+        o << item.n << "," << item.fen << "," << csv_quote(item.id) << "," << uci << ",";
+        if (mate) o << "," << mate_in_moves(score);
+        else      o << score << ",";
+        o << "," << nodes << "," << ms << "\n";
+      } else {
+        o << "{\"n\":" << item.n << ",\"fen\":\"" << item.fen << "\"";
+        if (!item.id.empty()) o << ",\"id\":\"" << json_escape(item.id) << "\"";
+        o << ",\"bestmove\":\"" << uci << "\"";
+        if (mate) o << ",\"score_mate\":" << mate_in_moves(score);
+        else      o << ",\"score_cp\":" << score;
+        o << ",\"nodes\":" << nodes << ",\"time_ms\":" << ms << "}\n";
+      }
+      {
+        lock_guard<mutex> lock(outm);
+        cout << o.str();
+      }
+      done.fetch_add(1, memory_order_relaxed);
+      totalNodes.fetch_add(nodes, memory_order_relaxed);
+    }
+  };
 
-    // actualizar “prev” con el score final de este depth (post re-search)
-    prev = score;
+  auto t0 = chrono::steady_clock::now();
+  vector<thread> pool;
+  for (int i = 0; i < jobs; i++) pool.emplace_back(worker);
 
-    if (pv != 0) {
-      bestEnc = pv;
-      bestScore = score;
-      best = decode_move(bestEnc);
+  string line;
+  uint64_t n = 0;
+  while (getline(in, line)) {
+    n++;
+    AnalyzeItem item;
+    item.n = n;
+    if (line.empty() || line[0] == '#') continue;
+    if (!parse_epd_line(line, item.fen, item.id)) {
+      lock_guard<mutex> lock(outm);
+      cerr << "analyze: line " << n << ": not a FEN/EPD\n";
+      continue;
     }
+    unique_lock<mutex> lock(qm);
+    notFull.wait(lock, [&] { return queue.size() < QUEUE_CAP; });
+    queue.push_back(move(item));
+    lock.unlock();
+    notEmpty.notify_one();
+  }
+  {
+    lock_guard<mutex> lock(qm);
+    eof = true;
+  }
+  notEmpty.notify_all();
+  for (auto& t : pool) t.join();
+  cout.flush();
+
+  double sec = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+  uint64_t nodes = totalNodes.load();
+  cerr << "analyze: " << done.load() << " positions, " << nodes << " nodes, "
+       << (uint64_t)(sec > 0 ? nodes / sec : 0) << " nps, " << (uint64_t)(sec * 1000) << " ms\n";
+  return 0;
+}
 
-    // NPS real (tiempo transcurrido)
-    auto now = chrono::steady_clock::now();
-    double sec = chrono::duration<double>(now - start).count();
-    int nps = (sec > 0.0) ? (int)(st.nodes / sec) : 0;
-
-    outScoreCp = bestScore;
-    cout << "info depth " << depth
-         << " score cp " << bestScore
-         << " nodes " << st.nodes
-         << " nps " << nps
-         << "\n";
+// ---------------- UCI ----------------
+// Estado del loop UCI (una partida; serve tiene uno por sesión)
+static Board UCI_BOARD;
+static string UCI_POSITION_BASE;   // ver uci_position
+static vector<string> UCI_HISTORY;
+
+// Una línea UCI; false en "quit". La usan el loop de stdin y la API WASM.
+static bool uci_command(const string& line) {
+  if (line == "uci") {
+    uci_send("id name BM-Engine");
+    uci_send("id author Benja");
+    uci_send("option name Hash type spin default " + to_string(DEFAULT_HASH_MB) + " min 1 max " + to_string(MAX_HASH_MB));
+    uci_send("option name Threads type spin default 1 min 1 max " + to_string(MAX_UCI_THREADS));
+    uci_send("option name Ponder type check default false");
+    uci_send("option name BookFile type string default <empty>");
+    uci_send("option name EvalFile type string default <empty>");
+    uci_send("option name SyzygyPath type string default <empty>");
+    uci_send("option name SyzygyProbeLimit type spin default 7 min 0 max 7");
+    uci_send("option name MultiPV type spin default 1 min 1 max " + to_string(MAX_MULTI_PV));
+    send_strength_options();
+    uci_send("option name SearchCache type string default <empty>");
+    uci_send("option name SearchCacheMB type spin default 64 min 1 max 4096");
+    uci_send("option name SearchCacheDepth type spin default 12 min 1 max " + to_string(MAX_SEARCH_DEPTH));
+    uci_send("uciok");
+  }
+  else if (line == "isready") {
+    uci_send("readyok");
+  }
+  else if (line == "debug on" || line == "debug off") {
+    // puede llegar en plena búsqueda: lo toma desde la próxima iteración
+    SEARCH_CTL.debug.store(line == "debug on");
+    if (!SEARCH_STATS_ENABLED && line == "debug on")
+      uci_send("info string stats compiled out (BM_SEARCH_STATS=OFF)");
+  }
+  else if (line == "stop") {
+    stop_search();
+  }
+  else if (line == "ponderhit") {
+    // arranca el reloj: el deadline se fija antes de soltar el flag de ponder
+    SEARCH_CTL.set_limits(PONDER_BUDGET);
+    SEARCH_CTL.ponder.store(false);
+  }
+  else if (line == "ucinewgame") {
+    stop_search();
+    TT.clear();
+    UCI_BOARD.set_startpos();
+    UCI_POSITION_BASE.clear();
+    UCI_HISTORY.clear();
+  }
+  else if (line.rfind("setoption name Hash value", 0) == 0) {
+    stop_search();
+    auto tok = split_ws(line);
+    int mb = DEFAULT_HASH_MB;
+    if (!tok.empty()) mb = stoi(tok.back());
+    TT.resize_mb(clamp(mb, 1, MAX_HASH_MB));
+  }
+  else if (line.rfind("setoption name BookFile value", 0) == 0) {
+    stop_search();
+    BOOK_FILE = line.substr(string("setoption name BookFile value").size());
+    BOOK_FILE.erase(0, BOOK_FILE.find_first_not_of(' '));
+    if (BOOK_FILE.empty() || BOOK_FILE == "<empty>") BOOK.close();
+    else if (BOOK.open(BOOK_FILE)) uci_send("info string book " + BOOK_FILE + " entries " + to_string(BOOK.size()));
+    else uci_send("info string book " + BOOK_FILE + " could not be opened");
+  }
+  else if (line.rfind("setoption name SyzygyPath value", 0) == 0) {
+    stop_search();
+    set_syzygy_path(line.substr(string("setoption name SyzygyPath value").size()));
+  }
+  else if (line.rfind("setoption name SyzygyProbeLimit value", 0) == 0) {
+    stop_search();
+    SYZYGY_PROBE_LIMIT = clamp(atoi(split_ws(line).back().c_str()), 0, 7);
+  }
+  else if (line.rfind("setoption name EvalFile value", 0) == 0) {
+    // "<empty>" vuelve a la eval clásica
+    stop_search();
+    set_eval_file(line.substr(string("setoption name EvalFile value").size()));
+  }
+  else if (line.rfind("setoption name MultiPV value", 0) == 0) {
+    stop_search();
+    SEARCH_CTL.multipv = parse_multipv(line);
+  }
+  else if (parse_strength_option(line, STRENGTH)) {
+    stop_search();
+    SEARCH_CTL.skill = STRENGTH.effective();
+  }
+  else if (line.rfind("setoption name SearchCacheMB value", 0) == 0) {
+    SEARCH_CACHE_MB = clamp(atoi(split_ws(line).back().c_str()), 1, 4096);
+  }
+  else if (line.rfind("setoption name SearchCacheDepth value", 0) == 0) {
+    SEARCH_CACHE_MIN_DEPTH = clamp(atoi(split_ws(line).back().c_str()), 1, MAX_SEARCH_DEPTH);
+  }
+  else if (line.rfind("setoption name SearchCache value", 0) == 0) {
+    stop_search();
+    set_search_cache(line.substr(string("setoption name SearchCache value").size()));
+  }
+  else if (line.rfind("setoption name Threads value", 0) == 0) {
+    stop_search();
+    auto tok = split_ws(line);
+    int n = 1;
+    if (!tok.empty()) n = stoi(tok.back());
+    SEARCH_THREADS = max(1, min(MAX_UCI_THREADS, n));
+  }
+  else if (line.rfind("position", 0) == 0) {
+    stop_search();
+    uci_position(UCI_BOARD, line, UCI_POSITION_BASE, UCI_HISTORY);
+  }
+  else if (line.rfind("go", 0) == 0) {
+    stop_search();
+    GoParams gp = parse_go(line);
+    if constexpr (!HAS_THREADS) {
+      // sin threads nadie puede mandar "stop" mientras busca: se busca por tiempo
+      if (gp.infinite || gp.ponder) uci_send("info string go infinite/ponder need a threaded build");
+      gp.infinite = gp.ponder = false;
+      prepare_go(SEARCH_CTL, UCI_BOARD, gp, PONDER_BUDGET);
+      search_go(UCI_BOARD, UCI_HISTORY, gp, SEARCH_CTL);
+    } else {
+      prepare_go(SEARCH_CTL, UCI_BOARD, gp, PONDER_BUDGET);
+      SEARCH_THREAD = thread(search_go, UCI_BOARD, UCI_HISTORY, gp, ref(SEARCH_CTL));
+    }
+  }
+  else if (line == "quit") {
+    return false;
   }
+  return true;
+}
 
-  outScoreCp = bestScore;
-  return best;
+#if defined(BM_WASM_API)
+// ---------------- API WASM ----------------
+// bm_wasm (Emscripten): el Web Worker llama bm_init() una vez y bm_command()
+// por cada línea UCI; cada línea de salida llega a Module.onEngineLine en el
+// thread del worker (desde los pthreads de búsqueda, encolada).
+static constexpr const char* WASM_BOOK_PATH = "/book.bin";   // --embed-file (BM_WASM_BOOK)
+
+static void wasm_output(const string& line) {
+  char* copy = strdup(line.c_str());   // lo libera el JS al entregarla
+  MAIN_THREAD_ASYNC_EM_ASM({
+    Module.onEngineLine(UTF8ToString($0));
+    _free($0);
+  }, copy);
 }
 
+extern "C" {
 
+EMSCRIPTEN_KEEPALIVE void bm_init() {
+  init_attack_tables();
+  init_zobrist();
+  init_search_tables();
+  TT.resize_mb(DEFAULT_HASH_MB);
+  UCI_OUTPUT_HOOK = wasm_output;
+  if (BOOK.open(WASM_BOOK_PATH)) BOOK_FILE = WASM_BOOK_PATH;
+  UCI_BOARD.set_startpos();
+}
 
+// 0 después de "quit"
+EMSCRIPTEN_KEEPALIVE int bm_command(const char* line) {
+  return uci_command(line) ? 1 : 0;
+}
 
-  // ---------------- main ----------------
+}
+#else
+// ---------------- main ----------------
 int main(int argc, char** argv) {
   ios::sync_with_stdio(false);
   cin.tie(nullptr);
-  cout.setf(std::ios::unitbuf);
 
   init_attack_tables();
   init_zobrist();
+  init_search_tables();
 
-  if (TT.t.empty()) TT.resize_mb(64);
+  if (TT.size() == 0) TT.resize_mb(DEFAULT_HASH_MB);
 
   // CLI tools
   if (argc >= 2) {
     string cmd = argv[1];
-    if (cmd == "perft" && argc >= 3) {
-      int depth = stoi(argv[2]);
-      Board b; b.set_startpos();
+    // perft <depth> [threads] [hashMB] / perftfen <fen> <depth> [threads] [hashMB]
+    // threads por defecto: todos los cores; hashMB 0 = sin cache
+    auto perft_args = [&](int first, int& threads, int& hashMb) {
+      threads = (int)max(1u, thread::hardware_concurrency());
+      hashMb = 0;
+      if (argc > first) threads = max(1, atoi(argv[first]));
+      if (argc > first + 1) hashMb = max(0, atoi(argv[first + 1]));
+    };
+    if ((cmd == "perft" || cmd == "perftfen") && argc >= (cmd == "perft" ? 3 : 4)) {
+      bool fen = (cmd == "perftfen");
+      int depth = stoi(argv[fen ? 3 : 2]);
+      int threads, hashMb;
+      perft_args(fen ? 4 : 3, threads, hashMb);
+      Board b;
+      if (fen) b.set_fen(argv[2]);
+      else b.set_startpos();
       auto t0 = chrono::steady_clock::now();
-      uint64_t nodes = perft(b, depth);
+      uint64_t nodes = perft_parallel(b, depth, threads, hashMb);
       auto t1 = chrono::steady_clock::now();
       double ms = chrono::duration<double, milli>(t1 - t0).count();
-      cout << "perft(" << depth << ") = " << nodes << "  [" << ms << " ms]\n";
+      cout << cmd << "(" << depth << ") = " << nodes << "  [" << ms << " ms]\n";
       return 0;
     }
-    if (cmd == "perftfen" && argc >= 4) {
-      string fen = argv[2];
-      int depth = stoi(argv[3]);
-      Board b; b.set_fen(fen);
-      auto t0 = chrono::steady_clock::now();
-      uint64_t nodes = perft(b, depth);
-      auto t1 = chrono::steady_clock::now();
-      double ms = chrono::duration<double, milli>(t1 - t0).count();
-      cout << "perftfen(" << depth << ") = " << nodes << "  [" << ms << " ms]\n";
+    if ((cmd == "divide" || cmd == "dividefen") && argc >= (cmd == "divide" ? 3 : 4)) {
+      bool fen = (cmd == "dividefen");
+      int depth = stoi(argv[fen ? 3 : 2]);
+      int threads, hashMb;
+      perft_args(fen ? 4 : 3, threads, hashMb);
+      Board b;
+      if (fen) b.set_fen(argv[2]);
+      else b.set_startpos();
+      perft_divide(b, depth, threads, hashMb);
       return 0;
     }
-    if (cmd == "divide" && argc >= 3) {
-      int depth = stoi(argv[2]);
-      Board b; b.set_startpos();
-      perft_divide(b, depth);
-      return 0;
-    }
-    if (cmd == "dividefen" && argc >= 4) {
-      string fen = argv[2];
-      int depth = stoi(argv[3]);
-      Board b; b.set_fen(fen);
-      perft_divide(b, depth);
-      return 0;
-    }
-  }
-
-  // UCI mode
-  Board board;
-  board.set_startpos();
-  vector<string> move_history;
-
-  string line;
-  while (getline(cin, line)) {
-    if (line == "uci") {
-      cout << "id name BM-Engine\n";
-      cout << "id author Benja\n";
-      cout << "option name Hash type spin default 64 min 1 max 2048\n";
-      cout << "option name Threads type spin default 1 min 1 max 32\n";
-      cout << "uciok\n";
-    }
-    else if (line == "isready") {
-      cout << "readyok\n";
+    if (cmd == "bench" && argc >= 4 && string(argv[2]) == "nnue") {
+      int depth = argc > 4 ? atoi(argv[4]) : 9;
+      int movetime = argc > 5 ? atoi(argv[5]) : 100;
+      int games = argc > 6 ? atoi(argv[6]) : 20;
+      return run_bench_nnue(argv[3], max(1, min(depth, MAX_SEARCH_DEPTH)), max(1, movetime), games);
     }
-    else if (line == "ucinewgame") {
-      board.set_startpos();
-      move_history.clear();
+    if (cmd == "bench") {
+      int depth = argc > 2 ? atoi(argv[2]) : BENCH_DEFAULT_DEPTH;
+      int threads = argc > 3 ? atoi(argv[3]) : 1;
+      int hashMb = argc > 4 ? atoi(argv[4]) : 16;
+      return run_bench(max(1, min(depth, MAX_SEARCH_DEPTH)), threads, hashMb);
     }
-    else if (line.rfind("setoption name Hash value", 0) == 0) {
-      auto tok = split_ws(line);
-      int mb = 64;
-      if (!tok.empty()) mb = stoi(tok.back());
-      TT.resize_mb(mb);
-    }
-    else if (line.rfind("position", 0) == 0) {
-      uci_position(board, line, move_history);
-    }
-    else if (line.rfind("go", 0) == 0) {
-      GoParams gp = parse_go(line);
-      int movetime = (gp.depth > 0 ? 0 : choose_movetime_ms(board, gp));
-      int maxDepth = (gp.depth > 0 ? gp.depth : 20);
-      int score = 0;
-
-      vector<Move> legal;
-      board.gen_legal(legal);
-
-      vector<string> legal_uci;
-      legal_uci.reserve(legal.size());
-      for (const auto& m : legal) legal_uci.push_back(move_to_uci(m));
-
-      constexpr size_t BOOK_MAX_PLIES = 12;
-      auto book_move = opening_book_pick(move_history, legal_uci);
-      if (book_move && move_history.size() <= BOOK_MAX_PLIES && !has_critical_tactics(board, legal)) {
-        auto itLegal = find(legal_uci.begin(), legal_uci.end(), *book_move);
-        bool valid_book_move = (itLegal != legal_uci.end());
-
-        if (valid_book_move && is_early_queen_move_uci(*book_move, move_history.size())) {
-          valid_book_move = false;
-        }
-
-        if (valid_book_move) {
-          size_t idx = static_cast<size_t>(distance(legal_uci.begin(), itLegal));
-          if (idx < legal.size() && !move_keeps_king_safe(board, legal[idx])) {
-            valid_book_move = false;
-          }
-        }
-
-        if (valid_book_move) {
-          cout << "info string bookhit move=" << *book_move << "\n";
-          cout << "bestmove " << *book_move << "\n";
-          continue;
-        }
+    if (cmd == "analyze") {
+      AnalyzeOptions opt;
+      for (int i = 2; i < argc; i++) {
+        string flag = argv[i];
+        if (flag == "--shared-tt") { opt.shared_tt = true; continue; }
+        if (i + 1 >= argc) { cerr << "analyze: missing value for " << flag << "\n"; return 1; }
+        string v = argv[++i];
+        if (flag == "--input") opt.input = v;
+        else if (flag == "--depth") opt.depth = atoi(v.c_str());
+        else if (flag == "--nodes") opt.nodes = strtoull(v.c_str(), nullptr, 10);
+        else if (flag == "--jobs") opt.jobs = atoi(v.c_str());
+        else if (flag == "--hash") opt.hash_mb = max(1, atoi(v.c_str()));
+        else if (flag == "--format" && (v == "jsonl" || v == "csv")) opt.csv = (v == "csv");
+        else { cerr << "analyze: unknown option " << flag << " " << v << "\n"; return 1; }
       }
-
-      Move bm = search_bestmove(board, movetime, maxDepth, score);
-
-      // Validate best move exists; if none, 0000
-      string out = legal.empty() ? "0000" : move_to_uci(legal[0]); // fallback legal
-      bool matched = false;
-
-      for (auto &m : legal) {
-        if (m.from == bm.from && m.to == bm.to && m.promo == bm.promo) {
-          out = move_to_uci(m);
-          matched = true;
-          break;
-        }
-      }
-
-      // Si no matcheó pero había legales, NO es terminal. Solo fue “bestmove inválido”.
-      if (!matched && !legal.empty()) {
-        cout << "info string fallback_bestmove_used\n";
+      return run_analyze(opt);
+    }
+    if (cmd == "serve") {
+      int sessions = 1, threads = 1;
+      for (int i = 2; i + 1 < argc; i += 2) {
+        string flag = argv[i];
+        int v = atoi(argv[i + 1]);
+        if (flag == "--sessions") sessions = v;
+        else if (flag == "--threads") threads = v;
+        else { cerr << "serve: unknown option " << flag << "\n"; return 1; }
       }
-
-      cout << "bestmove " << out << "\n";
+      return run_serve(sessions, threads);
     }
-    else if (line == "quit") {
-      break;
+    if (cmd == "buildbook" && argc >= 4) {
+      BookBuildOptions opt;
+      for (int i = 4; i + 1 < argc; i += 2) {
+        string flag = argv[i];
+        int v = atoi(argv[i + 1]);
+        if (flag == "--min-elo") opt.min_elo = v;
+        else if (flag == "--min-games") opt.min_games = v;
+        else if (flag == "--max-ply") opt.max_ply = v;
+        else if (flag == "--threads") opt.threads = v;
+        else { cerr << "buildbook: unknown option " << flag << "\n"; return 1; }
+      }
+      return build_book(argv[2], argv[3], opt);
     }
   }
+
+  // UCI mode
+  UCI_BOARD.set_startpos();
+  string line;
+  while (getline(cin, line))
+    if (!uci_command(line)) break;
+  stop_search();
   return 0;
 }
+#endif
@@ -0,0 +1,154 @@
+// Micro-benchmarks (Google Benchmark) de los caminos calientes de bm_core:
+// cada iteración es una llamada, sobre las posiciones de BENCH_FENS.
+#include <benchmark/benchmark.h>
+
+#include "engine.h"
+#include "opening_book.h"
+
+namespace {
+
+vector<Board> corpus_boards() {
+  vector<Board> boards;
+  for (const auto& fen : BENCH_FENS) {
+    Board b;
+    if (b.set_fen(fen)) boards.push_back(b);
+  }
+  return boards;
+}
+
+// (posición, jugada legal) para make/unmake
+vector<pair<int, Move>> corpus_moves(const vector<Board>& boards) {
+  vector<pair<int, Move>> out;
+  for (int i = 0; i < (int)boards.size(); i++) {
+    MoveList l;
+    boards[i].gen_legal(l);
+    for (const auto& m : l) out.push_back({i, m});
+  }
+  return out;
+}
+
+void BM_GenLegal(benchmark::State& state) {
+  vector<Board> boards = corpus_boards();
+  MoveList l;
+  size_t i = 0;
+  for (auto _ : state) {
+    boards[i].gen_legal(l);
+    benchmark::DoNotOptimize(l.count);
+    if (++i == boards.size()) i = 0;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_GenLegal);
+
+void BM_MakeUnmake(benchmark::State& state) {
+  vector<Board> boards = corpus_boards();
+  auto moves = corpus_moves(boards);
+  size_t i = 0;
+  for (auto _ : state) {
+    auto& [bi, m] = moves[i];
+    Undo u;
+    boards[bi].make_move(m, u);
+    boards[bi].unmake_move(m, u);
+    benchmark::DoNotOptimize(boards[bi].key);
+    if (++i == moves.size()) i = 0;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MakeUnmake);
+
+void BM_IsSquareAttacked(benchmark::State& state) {
+  vector<Board> boards = corpus_boards();
+  size_t i = 0;
+  int sq = 0;
+  for (auto _ : state) {
+    const Board& b = boards[i];
+    benchmark::DoNotOptimize(b.is_square_attacked(sq, Color(sq & 1)));
+    if (++sq == 64) { sq = 0; if (++i == boards.size()) i = 0; }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_IsSquareAttacked);
+
+void BM_Eval(benchmark::State& state) {
+  vector<Board> boards = corpus_boards();
+  auto pawns = make_unique<PawnTable>();
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(eval(boards[i], *pawns));
+    if (++i == boards.size()) i = 0;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Eval);
+
+// Mitad hits (posiciones guardadas) y mitad misses (sus hijos, no guardados)
+void BM_TTProbe(benchmark::State& state) {
+  vector<Board> boards = corpus_boards();
+  auto moves = corpus_moves(boards);
+  TT.resize_mb(16);
+  TT.new_search();
+
+  vector<uint64_t> keys;
+  for (auto& [bi, m] : moves) {
+    Board& b = boards[bi];
+    TT.store(b.key, 8, TT_EXACT, 0, m);
+    keys.push_back(b.key);
+    Undo u;
+    b.make_move(m, u);
+    keys.push_back(b.key);
+    b.unmake_move(m, u);
+  }
+
+  size_t i = 0;
+  TTHit hit;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(TT.probe(keys[i], hit));
+    if (++i == keys.size()) i = 0;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TTProbe);
+
+void BM_OpeningBookPick(benchmark::State& state) {
+  const vector<vector<string>> histories = {
+      {}, {"e2e4"}, {"e2e4", "e7e5", "g1f3"}, {"d2d4", "d7d5", "c2c4"}, {"a2a3"}};
+
+  vector<vector<string>> legal;
+  for (const auto& h : histories) {
+    Board b;
+    b.set_startpos();
+    for (const auto& uci : h) {
+      MoveList l;
+      b.gen_legal(l);
+      for (const auto& m : l)
+        if (move_to_uci(m) == uci) { Undo u; b.make_move(m, u); break; }
+    }
+    MoveList l;
+    b.gen_legal(l);
+    vector<string> ucis;
+    for (const auto& m : l) ucis.push_back(move_to_uci(m));
+    legal.push_back(ucis);
+  }
+
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(opening_book_pick(histories[i], legal[i]));
+    if (++i == histories.size()) i = 0;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_OpeningBookPick);
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  init_attack_tables();
+  init_zobrist();
+  init_search_tables();
+
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
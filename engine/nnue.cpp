@@ -0,0 +1,247 @@
+#include "nnue.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define NNUE_X86 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define NNUE_NEON 1
+#elif defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#define NNUE_WASM 1
+#endif
+
+// ---------------- Kernels de salida ----------------
+// sum(crelu(us) * w[0..H)) + sum(crelu(them) * w[H..2H)). Los x86 se compilan
+// con target() para que un binario genérico use AVX2 / AVX-512 si la CPU los tiene.
+using ForwardFn = int32_t (*)(const int16_t* us, const int16_t* them, const int16_t* w);
+
+static int32_t forward_scalar(const int16_t* us, const int16_t* them, const int16_t* w) {
+  int32_t sum = 0;
+  for (int i = 0; i < NNUE_HIDDEN; i++) {
+    sum += std::clamp<int32_t>(us[i], 0, NNUE_QA) * w[i];
+    sum += std::clamp<int32_t>(them[i], 0, NNUE_QA) * w[NNUE_HIDDEN + i];
+  }
+  return sum;
+}
+
+#if defined(NNUE_X86)
+__attribute__((target("avx2")))
+static int32_t forward_avx2(const int16_t* us, const int16_t* them, const int16_t* w) {
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i qa = _mm256_set1_epi16(NNUE_QA);
+  __m256i acc = _mm256_setzero_si256();
+  for (int side = 0; side < 2; side++) {
+    const int16_t* a = side ? them : us;
+    const int16_t* ws = w + side * NNUE_HIDDEN;
+    for (int i = 0; i < NNUE_HIDDEN; i += 16) {
+      __m256i v = _mm256_load_si256((const __m256i*)(a + i));
+      v = _mm256_min_epi16(_mm256_max_epi16(v, zero), qa);
+      acc = _mm256_add_epi32(acc, _mm256_madd_epi16(v, _mm256_load_si256((const __m256i*)(ws + i))));
+    }
+  }
+  __m128i s = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+  s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4E));
+  s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xB1));
+  return _mm_cvtsi128_si32(s);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static int32_t forward_avx512(const int16_t* us, const int16_t* them, const int16_t* w) {
+  const __m512i zero = _mm512_setzero_si512();
+  const __m512i qa = _mm512_set1_epi16(NNUE_QA);
+  __m512i acc = _mm512_setzero_si512();
+  for (int side = 0; side < 2; side++) {
+    const int16_t* a = side ? them : us;
+    const int16_t* ws = w + side * NNUE_HIDDEN;
+    for (int i = 0; i < NNUE_HIDDEN; i += 32) {
+      __m512i v = _mm512_load_si512((const void*)(a + i));
+      v = _mm512_min_epi16(_mm512_max_epi16(v, zero), qa);
+      acc = _mm512_add_epi32(acc, _mm512_madd_epi16(v, _mm512_load_si512((const void*)(ws + i))));
+    }
+  }
+  // suma horizontal en dos mitades de 256 como en AVX2, pasando por memoria: los
+  // extract / cast / reduce de 512 de GCC dan -Wuninitialized (operando "undefined")
+  alignas(64) int32_t lanes[16];
+  _mm512_store_si512((void*)lanes, acc);
+  __m256i h = _mm256_add_epi32(_mm256_load_si256((const __m256i*)lanes),
+                               _mm256_load_si256((const __m256i*)(lanes + 8)));
+  __m128i s = _mm_add_epi32(_mm256_castsi256_si128(h), _mm256_extracti128_si256(h, 1));
+  s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4E));
+  s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xB1));
+  return _mm_cvtsi128_si32(s);
+}
+#endif
+
+#if defined(NNUE_NEON)
+static int32_t forward_neon(const int16_t* us, const int16_t* them, const int16_t* w) {
+  const int16x8_t zero = vdupq_n_s16(0);
+  const int16x8_t qa = vdupq_n_s16(NNUE_QA);
+  int32x4_t acc = vdupq_n_s32(0);
+  for (int side = 0; side < 2; side++) {
+    const int16_t* a = side ? them : us;
+    const int16_t* ws = w + side * NNUE_HIDDEN;
+    for (int i = 0; i < NNUE_HIDDEN; i += 8) {
+      int16x8_t v = vminq_s16(vmaxq_s16(vld1q_s16(a + i), zero), qa);
+      int16x8_t wv = vld1q_s16(ws + i);
+      acc = vmlal_s16(acc, vget_low_s16(v), vget_low_s16(wv));
+      acc = vmlal_high_s16(acc, v, wv);
+    }
+  }
+  return vaddvq_s32(acc);
+}
+#endif
+
+#if defined(NNUE_WASM)
+// WASM SIMD (-msimd128): sin dispatch, el navegador lo soporta o el módulo no carga
+static int32_t forward_wasm(const int16_t* us, const int16_t* them, const int16_t* w) {
+  const v128_t zero = wasm_i16x8_splat(0);
+  const v128_t qa = wasm_i16x8_splat(NNUE_QA);
+  v128_t acc = wasm_i32x4_splat(0);
+  for (int side = 0; side < 2; side++) {
+    const int16_t* a = side ? them : us;
+    const int16_t* ws = w + side * NNUE_HIDDEN;
+    for (int i = 0; i < NNUE_HIDDEN; i += 8) {
+      v128_t v = wasm_i16x8_min(wasm_i16x8_max(wasm_v128_load(a + i), zero), qa);
+      acc = wasm_i32x4_add(acc, wasm_i32x4_dot_i16x8(v, wasm_v128_load(ws + i)));
+    }
+  }
+  return wasm_i32x4_extract_lane(acc, 0) + wasm_i32x4_extract_lane(acc, 1) +
+         wasm_i32x4_extract_lane(acc, 2) + wasm_i32x4_extract_lane(acc, 3);
+}
+#endif
+
+// ---------------- Kernels del acumulador ----------------
+// acc[0..H) += / -= w[0..H); filas de ft_w y acumulador alineados a 64.
+void nnue_row_add_scalar(int16_t* acc, const int16_t* w) {
+  for (int i = 0; i < NNUE_HIDDEN; i++) acc[i] += w[i];
+}
+
+void nnue_row_sub_scalar(int16_t* acc, const int16_t* w) {
+  for (int i = 0; i < NNUE_HIDDEN; i++) acc[i] -= w[i];
+}
+
+#if defined(NNUE_X86)
+__attribute__((target("avx2")))
+static void row_add_avx2(int16_t* acc, const int16_t* w) {
+  for (int i = 0; i < NNUE_HIDDEN; i += 16) {
+    __m256i a = _mm256_load_si256((const __m256i*)(acc + i));
+    _mm256_store_si256((__m256i*)(acc + i), _mm256_add_epi16(a, _mm256_load_si256((const __m256i*)(w + i))));
+  }
+}
+
+__attribute__((target("avx2")))
+static void row_sub_avx2(int16_t* acc, const int16_t* w) {
+  for (int i = 0; i < NNUE_HIDDEN; i += 16) {
+    __m256i a = _mm256_load_si256((const __m256i*)(acc + i));
+    _mm256_store_si256((__m256i*)(acc + i), _mm256_sub_epi16(a, _mm256_load_si256((const __m256i*)(w + i))));
+  }
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void row_add_avx512(int16_t* acc, const int16_t* w) {
+  for (int i = 0; i < NNUE_HIDDEN; i += 32) {
+    __m512i a = _mm512_load_si512((const void*)(acc + i));
+    _mm512_store_si512((void*)(acc + i), _mm512_add_epi16(a, _mm512_load_si512((const void*)(w + i))));
+  }
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void row_sub_avx512(int16_t* acc, const int16_t* w) {
+  for (int i = 0; i < NNUE_HIDDEN; i += 32) {
+    __m512i a = _mm512_load_si512((const void*)(acc + i));
+    _mm512_store_si512((void*)(acc + i), _mm512_sub_epi16(a, _mm512_load_si512((const void*)(w + i))));
+  }
+}
+#endif
+
+#if defined(NNUE_NEON)
+static void row_add_neon(int16_t* acc, const int16_t* w) {
+  for (int i = 0; i < NNUE_HIDDEN; i += 8) vst1q_s16(acc + i, vaddq_s16(vld1q_s16(acc + i), vld1q_s16(w + i)));
+}
+
+static void row_sub_neon(int16_t* acc, const int16_t* w) {
+  for (int i = 0; i < NNUE_HIDDEN; i += 8) vst1q_s16(acc + i, vsubq_s16(vld1q_s16(acc + i), vld1q_s16(w + i)));
+}
+#endif
+
+#if defined(NNUE_WASM)
+static void row_add_wasm(int16_t* acc, const int16_t* w) {
+  for (int i = 0; i < NNUE_HIDDEN; i += 8)
+    wasm_v128_store(acc + i, wasm_i16x8_add(wasm_v128_load(acc + i), wasm_v128_load(w + i)));
+}
+
+static void row_sub_wasm(int16_t* acc, const int16_t* w) {
+  for (int i = 0; i < NNUE_HIDDEN; i += 8)
+    wasm_v128_store(acc + i, wasm_i16x8_sub(wasm_v128_load(acc + i), wasm_v128_load(w + i)));
+}
+#endif
+
+static ForwardFn FORWARD = forward_scalar;
+static const char* FORWARD_NAME = "scalar";
+
+static void set_kernels(ForwardFn fwd, NnueRowFn add, NnueRowFn sub, const char* name) {
+  FORWARD = fwd;
+  NNUE_ROW_ADD = add;
+  NNUE_ROW_SUB = sub;
+  FORWARD_NAME = name;
+}
+
+static void select_kernel() {
+#if defined(NNUE_X86)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512bw")) { set_kernels(forward_avx512, row_add_avx512, row_sub_avx512, "avx512"); return; }
+  if (__builtin_cpu_supports("avx2")) { set_kernels(forward_avx2, row_add_avx2, row_sub_avx2, "avx2"); return; }
+#elif defined(NNUE_NEON)
+  set_kernels(forward_neon, row_add_neon, row_sub_neon, "neon"); return;
+#elif defined(NNUE_WASM)
+  set_kernels(forward_wasm, row_add_wasm, row_sub_wasm, "wasm-simd"); return;
+#endif
+  set_kernels(forward_scalar, nnue_row_add_scalar, nnue_row_sub_scalar, "scalar");
+}
+
+const char* nnue_kernel_name() { return FORWARD_NAME; }
+
+int nnue_evaluate(const NnueAccumulator& acc, int stm) {
+  const NnueNet& n = *NNUE_NET;
+  int64_t sum = (int64_t)FORWARD(acc.v[stm], acc.v[stm ^ 1], n.out_w) + n.out_b;
+  return (int)std::clamp<int64_t>(sum * NNUE_SCALE / (NNUE_QA * NNUE_QB), -NNUE_MAX_EVAL, NNUE_MAX_EVAL);
+}
+
+// ---------------- Carga ----------------
+bool nnue_load(const std::string& path, std::string& err) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) { err = "cannot open " + path; return false; }
+
+  char magic[8];
+  uint32_t inputs = 0, hidden = 0;
+  in.read(magic, 8);
+  in.read(reinterpret_cast<char*>(&inputs), 4);
+  in.read(reinterpret_cast<char*>(&hidden), 4);
+  if (!in || std::memcmp(magic, "BMNNUE01", 8) != 0) { err = "bad header"; return false; }
+  if (inputs != NNUE_INPUTS || hidden != NNUE_HIDDEN) {
+    err = "unsupported architecture " + std::to_string(inputs) + "x" + std::to_string(hidden);
+    return false;
+  }
+
+  auto net = std::make_unique<NnueNet>();
+  in.read(reinterpret_cast<char*>(net->ft_w), sizeof(net->ft_w));
+  in.read(reinterpret_cast<char*>(net->ft_b), sizeof(net->ft_b));
+  in.read(reinterpret_cast<char*>(net->out_w), sizeof(net->out_w));
+  in.read(reinterpret_cast<char*>(&net->out_b), sizeof(net->out_b));
+  if (!in) { err = "truncated file"; return false; }
+
+  select_kernel();
+  NNUE_NET = std::move(net);
+  NNUE_ON = true;
+  return true;
+}
+
+void nnue_unload() {
+  NNUE_ON = false;
+  NNUE_NET.reset();
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// ---------------- NNUE ----------------
+// Red 768 -> 2x256 -> 1 (perspectivas del que mueve y del rival, CReLU).
+// Entrada: pieza (color, tipo) x casilla, vista desde cada bando (el negro con
+// el tablero espejado). El acumulador (capa 768 -> 256 de cada perspectiva)
+// lo mantiene Board en put_piece / remove_piece; acá solo la capa de salida,
+// con kernel AVX-512 / AVX2 / NEON / WASM SIMD elegido al cargar según la CPU.
+//
+// Archivo (little-endian): "BMNNUE01", uint32 inputs (768), uint32 hidden (256),
+// int16 ft_w[768][256], int16 ft_b[256], int16 out_w[512], int32 out_b.
+// Cuantización: acumulador en escala QA, out_w en escala QB;
+// eval (cp) = (sum(crelu(acc) * out_w) + out_b) * SCALE / (QA * QB).
+inline constexpr int NNUE_INPUTS = 768;
+inline constexpr int NNUE_HIDDEN = 256;
+inline constexpr int NNUE_QA = 255;
+inline constexpr int NNUE_QB = 64;
+inline constexpr int NNUE_SCALE = 400;
+// Tope de la salida: fuera del rango de mate (MATE - 1000 en engine.h) aunque la red esté mal
+inline constexpr int NNUE_MAX_EVAL = 29000;
+
+struct NnueNet {
+  alignas(64) int16_t ft_w[NNUE_INPUTS][NNUE_HIDDEN];
+  alignas(64) int16_t ft_b[NNUE_HIDDEN];
+  alignas(64) int16_t out_w[2 * NNUE_HIDDEN];   // [0, H): el que mueve; [H, 2H): el rival
+  int32_t out_b = 0;
+};
+
+// Acumulador por perspectiva: [0] blancas, [1] negras
+struct NnueAccumulator {
+  alignas(64) int16_t v[2][NNUE_HIDDEN];
+};
+
+// Red cargada (nullptr = eval clásica). NNUE_ON se lee en el camino caliente
+// (Board, eval); cambiarlo solo sin búsquedas en curso.
+inline std::unique_ptr<NnueNet> NNUE_NET;
+inline bool NNUE_ON = false;
+
+// Carga la red; false (y 'err') si el archivo no existe o no coincide el formato.
+// Al cargar, NNUE_ON queda en true.
+bool nnue_load(const std::string& path, std::string& err);
+void nnue_unload();
+
+// Suma / resta de una fila de ft_w a una perspectiva del acumulador. Kernel
+// elegido al cargar junto con el de salida (nnue.cpp); el escalar hasta entonces.
+using NnueRowFn = void (*)(int16_t* acc, const int16_t* w);
+void nnue_row_add_scalar(int16_t* acc, const int16_t* w);
+void nnue_row_sub_scalar(int16_t* acc, const int16_t* w);
+inline NnueRowFn NNUE_ROW_ADD = nnue_row_add_scalar;
+inline NnueRowFn NNUE_ROW_SUB = nnue_row_sub_scalar;
+
+// Nombre del kernel de salida elegido ("avx512", "avx2", "neon", "wasm-simd", "scalar")
+const char* nnue_kernel_name();
+
+// Eval en cp desde la perspectiva de 'stm' (0 = blancas), en [-NNUE_MAX_EVAL, NNUE_MAX_EVAL]
+int nnue_evaluate(const NnueAccumulator& acc, int stm);
+
+// Índice de entrada de (color, tipo 1..6, casilla) visto desde 'persp'
+inline int nnue_feature(int persp, int color, int pt, int sq) {
+  if (persp == 1) { color ^= 1; sq ^= 56; }
+  return color * 384 + (pt - 1) * 64 + sq;
+}
+
+inline void nnue_add(NnueAccumulator& acc, int color, int pt, int sq) {
+  const NnueNet& n = *NNUE_NET;
+  NNUE_ROW_ADD(acc.v[0], n.ft_w[nnue_feature(0, color, pt, sq)]);
+  NNUE_ROW_ADD(acc.v[1], n.ft_w[nnue_feature(1, color, pt, sq)]);
+}
+
+inline void nnue_sub(NnueAccumulator& acc, int color, int pt, int sq) {
+  const NnueNet& n = *NNUE_NET;
+  NNUE_ROW_SUB(acc.v[0], n.ft_w[nnue_feature(0, color, pt, sq)]);
+  NNUE_ROW_SUB(acc.v[1], n.ft_w[nnue_feature(1, color, pt, sq)]);
+}
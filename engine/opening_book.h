@@ -1,6 +1,9 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <optional>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -14,3 +17,47 @@ struct BookCandidate {
 std::optional<std::string> opening_book_pick(
     const std::vector<std::string>& move_history,
     const std::vector<std::string>& legal_moves_uci);
+
+// ---------------- Libro binario ----------------
+// Formato (little-endian): cabecera de 16 bytes ("BMBOOK01" + cantidad de
+// entradas) y entradas de 16 bytes ordenadas por key, estilo Polyglot pero
+// con la key Zobrist del engine (Board::key) y la jugada en el formato
+// Move de 16 bits. Varias entradas por key = varias jugadas candidatas.
+struct BinaryBookEntry {
+  uint64_t key;
+  uint16_t move;    // Move::data
+  uint16_t weight;  // mayor = preferida
+  uint32_t learn;   // dato libre (p.ej. partidas que la jugaron)
+};
+static_assert(sizeof(BinaryBookEntry) == 16, "BinaryBookEntry debe ocupar 16 bytes");
+
+// Libro mapeado en memoria (mmap de solo lectura): abrir no copia el archivo
+// y cada consulta es una búsqueda binaria.
+class BinaryBook {
+ public:
+  BinaryBook() = default;
+  ~BinaryBook() { close(); }
+  BinaryBook(const BinaryBook&) = delete;
+  BinaryBook& operator=(const BinaryBook&) = delete;
+
+  bool open(const std::string& path);
+  void close();
+
+  bool loaded() const { return entries_ != nullptr; }
+  std::size_t size() const { return count_; }
+
+  // Entradas de 'key' en el orden del archivo (por jugada), sin copiar: apuntan
+  // al mapeo y valen hasta close(). Vacío si no está. Solo se compara la key de
+  // 64 bits: la jugada hay que validarla contra la posición.
+  std::span<const BinaryBookEntry> probe(uint64_t key) const;
+
+  // Ordena y escribe un libro; false si no se pudo escribir
+  static bool write(const std::string& path, std::vector<BinaryBookEntry> entries);
+
+ private:
+  const BinaryBookEntry* entries_ = nullptr;
+  std::size_t count_ = 0;
+  void* map_ = nullptr;
+  std::size_t map_bytes_ = 0;
+  std::vector<BinaryBookEntry> heap_;  // fallback sin mmap
+};
@@ -0,0 +1,110 @@
+#include "opening_book.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define BM_BOOK_MMAP 1
+#endif
+
+namespace {
+
+constexpr char BOOK_MAGIC[8] = {'B', 'M', 'B', 'O', 'O', 'K', '0', '1'};
+constexpr std::size_t HEADER_BYTES = 16;
+
+bool header_ok(const unsigned char* data, std::size_t bytes, std::size_t& count) {
+  if (bytes < HEADER_BYTES || std::memcmp(data, BOOK_MAGIC, sizeof(BOOK_MAGIC)) != 0) return false;
+  uint64_t n = 0;
+  std::memcpy(&n, data + 8, sizeof(n));
+  if (n > (bytes - HEADER_BYTES) / sizeof(BinaryBookEntry)) return false;
+  count = static_cast<std::size_t>(n);
+  return true;
+}
+
+bool by_key(const BinaryBookEntry& e, uint64_t k) { return e.key < k; }
+
+}  // namespace
+
+bool BinaryBook::open(const std::string& path) {
+  close();
+#if BM_BOOK_MMAP
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) return false;
+  struct stat stt;
+  if (fstat(fd, &stt) != 0 || stt.st_size < static_cast<off_t>(HEADER_BYTES)) {
+    ::close(fd);
+    return false;
+  }
+  std::size_t bytes = static_cast<std::size_t>(stt.st_size);
+  void* p = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (p == MAP_FAILED) return false;
+
+  std::size_t n = 0;
+  if (!header_ok(static_cast<const unsigned char*>(p), bytes, n)) {
+    munmap(p, bytes);
+    return false;
+  }
+  map_ = p;
+  map_bytes_ = bytes;
+  entries_ = reinterpret_cast<const BinaryBookEntry*>(static_cast<const unsigned char*>(p) + HEADER_BYTES);
+  count_ = n;
+  return true;
+#else
+  std::ifstream in(path, std::ios::binary | std::ios::ate);
+  if (!in) return false;
+  std::size_t bytes = static_cast<std::size_t>(in.tellg());
+  unsigned char header[HEADER_BYTES];
+  in.seekg(0);
+  in.read(reinterpret_cast<char*>(header), HEADER_BYTES);
+  std::size_t n = 0;
+  if (!in || !header_ok(header, bytes, n)) return false;
+  heap_.resize(n);
+  in.read(reinterpret_cast<char*>(heap_.data()), static_cast<std::streamsize>(n * sizeof(BinaryBookEntry)));
+  if (!in) { heap_.clear(); return false; }
+  entries_ = heap_.data();
+  count_ = n;
+  return true;
+#endif
+}
+
+void BinaryBook::close() {
+#if BM_BOOK_MMAP
+  if (map_) munmap(map_, map_bytes_);
+#endif
+  map_ = nullptr;
+  map_bytes_ = 0;
+  heap_.clear();
+  entries_ = nullptr;
+  count_ = 0;
+}
+
+std::span<const BinaryBookEntry> BinaryBook::probe(uint64_t key) const {
+  if (!entries_) return {};
+  const BinaryBookEntry* end = entries_ + count_;
+  const BinaryBookEntry* first = std::lower_bound(entries_, end, key, by_key);
+  const BinaryBookEntry* last = first;
+  while (last != end && last->key == key) ++last;
+  return {first, static_cast<std::size_t>(last - first)};
+}
+
+bool BinaryBook::write(const std::string& path, std::vector<BinaryBookEntry> entries) {
+  // orden total (key, move) para que el archivo sea determinista
+  std::sort(entries.begin(), entries.end(), [](const BinaryBookEntry& a, const BinaryBookEntry& b) {
+    return a.key != b.key ? a.key < b.key : a.move < b.move;
+  });
+
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  if (!out) return false;
+  uint64_t n = entries.size();
+  out.write(BOOK_MAGIC, sizeof(BOOK_MAGIC));
+  out.write(reinterpret_cast<const char*>(&n), sizeof(n));
+  out.write(reinterpret_cast<const char*>(entries.data()),
+            static_cast<std::streamsize>(entries.size() * sizeof(BinaryBookEntry)));
+  return static_cast<bool>(out);
+}
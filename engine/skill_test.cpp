@@ -0,0 +1,57 @@
+// Skill Level: con el presupuesto de nodos de un nivel bajo la jugada tiene que
+// salir de skill_pick (varias candidatas), no ser siempre la que encuentra una
+// búsqueda de fuerza completa con el mismo presupuesto. El presupuesto suele
+// agotarse a mitad de un depth MultiPV: ese caso tiene que seguir eligiendo.
+// Sale con 1 si falla (ctest).
+#include "engine.h"
+
+static const string FEN = "r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 3";
+static constexpr int LEVELS[] = {4, 10};
+static constexpr int TRIES = 64;
+
+static Move search(const Board& b, SearchControl& ctl, TranspositionTable& tt, const SkillBudget& budget) {
+  tt.clear();
+  ctl.reset();
+  ctl.node_limit.store(budget.nodes);
+  Board pos = b;
+  int score = 0;
+  return search_bestmove(pos, ctl, budget.depth, score);
+}
+
+int main() {
+  init_attack_tables();
+  init_zobrist();
+  init_search_tables();
+
+  Board b;
+  if (!b.set_fen(FEN)) { cerr << "skill_test: bad fen\n"; return 1; }
+  MoveList legal;
+  b.gen_legal(legal);
+
+  TranspositionTable tt;
+  tt.resize_mb(16);
+  SearchControl ctl;
+  ctl.quiet = true;
+  ctl.threads = 1;
+  ctl.tt = &tt;
+
+  bool ok = true;
+  for (int level : LEVELS) {
+    const SkillBudget budget = skill_budget(level);
+    ctl.skill = MAX_SKILL;
+    Move strongest = search(b, ctl, tt, budget);
+
+    ctl.skill = level;
+    int weaker = 0;
+    for (int i = 0; i < TRIES; i++) {
+      Move m = search(b, ctl, tt, budget);
+      if (!legal.contains(m)) { cerr << "skill_test: illegal move " << move_to_uci(m) << "\n"; return 1; }
+      if (m != strongest) weaker++;
+    }
+
+    cout << "skill_test: level " << level << " (" << budget.nodes << " nodes) played "
+         << weaker << "/" << TRIES << " moves other than " << move_to_uci(strongest) << "\n";
+    if (weaker == 0) ok = false;
+  }
+  return ok ? 0 : 1;
+}
@@ -6,10 +6,13 @@
 // con esta versión mejorada que mira 2-3 jugadas adelante
 //
 
+// eval() necesita una pawn hash; esta detección corre fuera de la búsqueda
+static PawnTable TACTICS_PAWNS;
+
 // Función auxiliar: evaluar si una posición es tácticamente crítica
 static bool is_position_tactical(const Board& b) {
   // Criterio 1: Pocas jugadas legales = posición forzada/táctica
-  vector<Move> legal;
+  MoveList legal;
   b.gen_legal(legal);
   if (legal.size() < 5) return true;
   
@@ -17,57 +20,30 @@ static bool is_position_tactical(const Board& b) {
   if (b.in_check(b.side)) return true;
   
   // Criterio 3: Evaluación extrema
-  int ev = eval(b);
+  int ev = eval(b, TACTICS_PAWNS);
   if (abs(ev) > 200) return true;  // Más de 2 peones de ventaja
   
   return false;
 }
 
 // Función auxiliar: verificar si hay piezas colgadas
+// Una pieza (no peón, no rey) está colgada si el rival puede capturarla con su
+// atacante de menor valor y el intercambio completo (SEE, con x-rays) le gana material.
 static bool has_hanging_pieces(const Board& b) {
-  for (int sq = 0; sq < 64; sq++) {
-    int8_t p = b.sq[sq];
-    if (p == 0 || color_of(p) != b.side) continue;
-    
-    int piece_type = abs_piece(p);
-    if (piece_type == PAWN) continue;  // Peones no cuentan como "colgadas"
-    
-    // Si la pieza está atacada
-    if (b.is_square_attacked(sq, Color(1 - b.side))) {
-      // Verificar si está defendida adecuadamente
-      // Para simplificar: si está atacada y vale >=300cp, considerarla en peligro
-      int piece_value = 0;
-      switch (piece_type) {
-        case KNIGHT: piece_value = 300; break;
-        case BISHOP: piece_value = 320; break;
-        case ROOK: piece_value = 500; break;
-        case QUEEN: piece_value = 900; break;
-        case KING: continue;  // Rey no cuenta
-      }
-      
-      if (piece_value >= 300) {
-        // Contar atacantes
-        int attackers = 0;
-        int defenders = 0;
-        
-        // Contar atacantes del oponente
-        for (int asq = 0; asq < 64; asq++) {
-          int8_t ap = b.sq[asq];
-          if (ap != 0 && color_of(ap) == Color(1 - b.side)) {
-            // Verificar si esta pieza ataca sq
-            vector<Move> aMoves;
-            // Generar pseudo-legales desde asq (simplificado)
-            // Por simplicidad, solo contamos 1 atacante si is_square_attacked devuelve true
-            attackers = 1;
-            break;
-          }
-        }
-        
-        // Si hay atacantes y la pieza está colgada, es crítico
-        if (attackers > 0) {
-          return true;
-        }
-      }
+  Color them = Color(1 - b.side);
+  Bitboard ours = b.occ[b.side] & ~(b.pieces[b.side][PAWN] | b.pieces[b.side][KING]);
+
+  while (ours) {
+    int sq = pop_lsb(ours);
+    Bitboard attackers = b.attackers_to(sq, them);
+    if (!attackers) continue;
+
+    // atacante de menor valor
+    for (int pt = PAWN; pt <= KING; pt++) {
+      Bitboard a = attackers & b.pieces[them][pt];
+      if (!a) continue;
+      if (b.see_ge(Move(lsb(a), sq, Move::CAPTURE), 1)) return true;
+      break;
     }
   }
   return false;
@@ -75,14 +51,14 @@ static bool has_hanging_pieces(const Board& b) {
 
 // FUNCIÓN PRINCIPAL MEJORADA
 // Detecta peligros tácticos mirando 2-3 jugadas adelante
-static bool has_critical_tactics(Board& b, const vector<Move>& legal) {
+static bool has_critical_tactics(Board& b, const MoveList& legal) {
   // Paso 1: Verificar posición actual
   if (is_position_tactical(b)) return true;
   if (has_hanging_pieces(b)) return true;
   
   // Paso 2: Mirar 1 jugada adelante (búsqueda superficial)
   // Si alguna de nuestras jugadas cambia drásticamente la evaluación, es táctica
-  int current_eval = eval(b);
+  int current_eval = eval(b, TACTICS_PAWNS);
   
   for (const auto& m : legal) {
     Undo u;
@@ -96,7 +72,7 @@ static bool has_critical_tactics(Board& b, const vector<Move>& legal) {
     }
     
     // 2. Hay un cambio drástico de evaluación
-    int new_eval = -eval(b);  // Desde nuestro punto de vista
+    int new_eval = -eval(b, TACTICS_PAWNS);  // Desde nuestro punto de vista
     if (abs(new_eval - current_eval) > 150) {
       b.unmake_move(m, u);
       return true;  // Cambio táctico grande
@@ -113,7 +89,7 @@ static bool has_critical_tactics(Board& b, const vector<Move>& legal) {
     Undo u1;
     b.make_move(our_move, u1);
     
-    vector<Move> opponent_moves;
+    MoveList opponent_moves;
     b.gen_legal(opponent_moves);
     
     // Ver si el oponente tiene alguna jugada táctica fuerte
@@ -122,7 +98,7 @@ static bool has_critical_tactics(Board& b, const vector<Move>& legal) {
       b.make_move(opp_move, u2);
       
       // Desde el punto de vista del oponente
-      int opp_eval = eval(b);
+      int opp_eval = eval(b, TACTICS_PAWNS);
       
       // Si el oponente puede ganar mucho material o dar mate
       if (opp_eval > 300) {  // Oponente gana 3+ peones
@@ -132,7 +108,7 @@ static bool has_critical_tactics(Board& b, const vector<Move>& legal) {
       }
       
       // Si nos dan jaque mate en 1
-      vector<Move> our_responses;
+      MoveList our_responses;
       b.gen_legal(our_responses);
       if (our_responses.empty() && b.in_check(b.side)) {
         b.unmake_move(opp_move, u2);
@@ -186,7 +162,7 @@ static bool has_critical_tactics(Board& b, const vector<Move>& legal) {
 //         Undo u;
 //         board.make_move(book_m, u);
 //         
-//         vector<Move> opp_legal;
+//         MoveList opp_legal;
 //         board.gen_legal(opp_legal);
 //         
 //         // Si después de la jugada del libro ya no hay peligro, usarla
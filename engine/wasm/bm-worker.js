@@ -0,0 +1,29 @@
+// Web Worker para bm_wasm: cada mensaje entrante es una línea UCI
+// ("position ...", "go movetime 300", ...) y cada línea de salida del motor
+// vuelve como mensaje. Uso desde la página:
+//   const engine = new Worker("bm-worker.js");
+//   engine.onmessage = (e) => console.log(e.data);
+//   engine.postMessage("uci");
+// Sin BM_WASM_THREADS "go" bloquea el worker hasta el bestmove: los comandos
+// que lleguen mientras tanto se atienden después (stop no corta la búsqueda).
+importScripts("bm_wasm.js");
+
+const pending = [];
+let engine = null;
+
+BMEngine({ onEngineLine: (line) => postMessage(line) }).then((module) => {
+  module._bm_init();
+  engine = module;
+  for (const line of pending.splice(0)) send(line);
+});
+
+function send(line) {
+  engine.ccall("bm_command", "number", ["string"], [line]);
+}
+
+onmessage = (e) => {
+  const line = String(e.data).trim();
+  if (!line) return;
+  if (engine) send(line);
+  else pending.push(line);
+};